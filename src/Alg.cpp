@@ -1,11 +1,17 @@
 #include "Alg.hpp"
+#include "Heuristic.hpp"
+#include "BitsetSolver.hpp"
 #include "unordered_set"
+#include <thread>
 
 using namespace std;
 
-Alg::Alg(const string &inputFile, const bool &checkIndependentSet) {
-    SearchNode *root = new SearchNode(inputFile, checkIndependentSet);
+Alg::Alg(const string &inputFile, const Options &options) : options(options), bounds(options.stats) {
+    Graph::localityOrder = options.reorder;
+    vector<uint32_t> inputIds;
+    SearchNode *root = new SearchNode(inputFile, options, inputIds);
     root->mis.setMisOutputFile(inputFile + ".mis");
+    root->mis.setInputIds(inputIds);
     searchTree.push_back(root);
 }
 
@@ -26,6 +32,8 @@ Alg::SearchNode::SearchNode(const SearchNode &searchNode, const uint32_t &parent
     leftChild = NONE;
     rightChild = NONE;
     finalMis = NULL;
+    lowerBound = searchNode.lowerBound;
+    cliqueCover = searchNode.cliqueCover;
     hasCut = false;
     cutIsDone = false;
     cut = searchNode.cut;
@@ -40,28 +48,68 @@ Alg::SearchNode::~SearchNode() {
 
 uint32_t searchNodeID = 0;
 
+/* Find an initial mis heuristically and write it out, then search for a larger one.
+ * The root search node is only of use if it beats the initial mis */
 void Alg::run() {
+    vector<uint32_t> initialMis;
+    Heuristic heuristic(searchTree[0]->graph, searchTree[0]->theta);
+    heuristic.run(initialMis);
+    Mis::print(initialMis, "Initial Independent Set");
+    searchTree[0]->lowerBound = initialMis.size();
+    if (options.blocks) {
+        searchTree[0]->reductions->run(searchTree[0]->theta);
+        searchTree[0]->foldBlocks();
+    }
+
+    vector<uint32_t> *finalMis;
+    if (options.threads) {
+        finalMis = runParallel();
+    } else if (options.trail) {
+        finalMis = runWithTrail();
+    } else {
+        finalMis = runWithCopies();
+    }
+    if (options.stats) {
+        bounds.printStats();
+        solutionCache.printStats();
+    }
+    Mis::print((finalMis->size() > initialMis.size() ? *finalMis : initialMis));
+    delete finalMis;
+}
+
+vector<uint32_t> *Alg::runWithCopies() {
     uint32_t searchNodes = 1;
+    uint32_t prunedSearchNodes = 0;
     uint32_t minCompletedSearchNode = NONE;
     bool down = true;
     uint32_t i = 0;
     while(true) {
         if (down) {
-            if (searchTree[i]->theta == 5 && !searchTree[i]->hasCut && searchTree[i]->handleCuts()) {
+            if (prune(searchTree[i], true, bounds)) {
+                prunedSearchNodes++;
+            } else if (searchTree[i]->theta == 5 && !searchTree[i]->hasCut && searchTree[i]->handleCuts()) {
                 ;
             } else {
                 searchTree[i]->reductions->run(searchTree[i]->theta);
                 //cout << "search node " << searchNodes ;
-                searchTree[i]->branchingRule.choose(searchTree[i]->graph, *(searchTree[i]->reductions), searchTree[i]->theta, searchTree[i]);
+                if (prune(searchTree[i], false, bounds)) {
+                    prunedSearchNodes++;
+                } else if (searchTree[i]->handleComponents() || searchTree[i]->handleSmallGraph(solutionCache)) {
+                    ;
+                } else {
+                    searchTree[i]->branchingRule.choose(searchTree[i]->graph, *(searchTree[i]->reductions), searchTree[i]->theta, searchTree[i]);
+                }
             }
         } else if (searchTree[i]->rightChild == NONE) {
             down = true;
             assert(searchTree[i]->branchingRule.type != BranchingRule::Type::DONE);
         }
-        if (down && searchTree[i]->branchingRule.type == BranchingRule::Type::DONE) {
+        if (down && (searchTree[i]->branchingRule.type == BranchingRule::Type::DONE || searchTree[i]->branchingRule.type == BranchingRule::Type::PRUNED)) {
             searchTree[i]->id = searchNodeID++;
             searchTree[i]->finalMis = new vector<uint32_t>();
-            searchTree[i]->mis.unfoldHypernodes(searchTree[i]->graph.zeroDegreeNodes, *searchTree[i]->finalMis);
+            if (searchTree[i]->branchingRule.type == BranchingRule::Type::DONE) {
+                searchTree[i]->mis.unfoldHypernodes(searchTree[i]->graph.zeroDegreeNodes, *searchTree[i]->finalMis);
+            }
             i = searchTree[i]->parent;
             if (i == NONE) {
                 break;
@@ -102,9 +150,12 @@ void Alg::run() {
         searchTree.push_back(searchNode);
         *nextChild = searchTree.size() - 1;
         if (nextChild == &searchTree[i]->leftChild) {
+            searchNode->lowerBound = getLeftLowerBound(searchTree[i]->branchingRule.type, searchTree[i]->lowerBound);
             branchLeft(searchTree[i]->branchingRule, searchNode, searchTree[i]->mis);
         }
         else if (nextChild == &searchTree[i]->rightChild) {
+            uint32_t leftMisSize = searchTree[searchTree[i]->leftChild]->finalMis->size();
+            searchNode->lowerBound = getRightLowerBound(searchTree[i]->branchingRule.type, searchTree[i]->lowerBound, leftMisSize);
             branchRight(searchTree[i]->branchingRule, searchNode, searchTree[i]->mis);
         }
         else {
@@ -112,16 +163,331 @@ void Alg::run() {
         }
         i = *nextChild;
     }
-    cout << searchNodes << " search nodes\n";
+    cout << searchNodes << " search nodes, " << prunedSearchNodes << " pruned\n";
     searchTree[0]->graph.collectZeroDegreeNodes();
     //cout << "Final id " << searchTree[0]->id;
-    Mis::print(*searchTree[0]->finalMis);
-    delete searchTree[0]->finalMis;
+    vector<uint32_t> *finalMis = searchTree[0]->finalMis;
+    searchTree[0]->finalMis = NULL;
+    return finalMis;
+}
+
+/* Same search as runWithCopies(), but on the root's graph only. Instead of copying the graph for every child,
+ * its modifications are recorded on the graph's trail, and undone when returning to the parent */
+vector<uint32_t> *Alg::runWithTrail() {
+    SearchNode *searchNode = searchTree[0];
+    Graph &graph = searchNode->graph;
+    graph.enableTrail();
+    vector<Frame *> frames;
+    vector<uint32_t> *finalMis = NULL;
+    uint32_t searchNodes = 1;
+    uint32_t prunedSearchNodes = 0;
+    uint32_t minCompletedDepth = NONE;
+    bool down = true;
+    while (true) {
+        if (down) {
+            if (prune(searchNode, true, bounds)) {
+                prunedSearchNodes++;
+            } else if (searchNode->theta == 5 && !searchNode->hasCut && searchNode->handleCuts()) {
+                ;
+            } else {
+                searchNode->reductions->run(searchNode->theta);
+                if (prune(searchNode, false, bounds)) {
+                    prunedSearchNodes++;
+                } else if (searchNode->handleComponents() || searchNode->handleSmallGraph(solutionCache)) {
+                    ;
+                } else {
+                    searchNode->branchingRule.choose(graph, *(searchNode->reductions), searchNode->theta, searchNode);
+                }
+            }
+            if (searchNode->branchingRule.type == BranchingRule::Type::DONE) {
+                finalMis = new vector<uint32_t>();
+                vector<uint32_t> zeroDegreeNodes(graph.zeroDegreeNodes);
+                searchNode->mis.unfoldHypernodes(zeroDegreeNodes, *finalMis);
+                down = false;
+            } else if (searchNode->branchingRule.type == BranchingRule::Type::PRUNED) {
+                finalMis = new vector<uint32_t>();
+                down = false;
+            } else {
+                Frame *frame = new Frame(*searchNode, graph.getTrailMark());
+                frames.push_back(frame);
+                searchNode->enterChild();
+                searchNode->lowerBound = getLeftLowerBound(frame->branchingRule.type, frame->lowerBound);
+                branchLeft(frame->branchingRule, searchNode, frame->mis);
+                searchNodes++;
+            }
+            continue;
+        }
+        if (frames.empty()) {
+            break;
+        }
+        Frame *frame = frames.back();
+        if (frame->leftMis == NULL) {
+            frame->leftMis = finalMis;
+        } else if (frame->hasCut && !frame->cutIsDone) {
+            if (frame->leftMis->size() == finalMis->size()) {
+                frame->branchingRule.type = BranchingRule::Type::CUT_RIGHT_1;
+            } else {
+                frame->branchingRule.type = BranchingRule::Type::CUT_RIGHT_2;
+            }
+            delete finalMis;
+            frame->cutIsDone = true;
+        } else {
+            if (frames.size() - 1 < minCompletedDepth) {
+                minCompletedDepth = frames.size() - 1;
+                cout << minCompletedDepth << endl;
+            }
+            graph.undo(frame->trailMark);
+            if (frame->hasCut) {
+                frame->leftMis->insert(frame->leftMis->end(), finalMis->begin(), finalMis->end());
+                delete finalMis;
+                graph.collectZeroDegreeNodes();
+                vector<uint32_t> zeroDegreeNodes(graph.zeroDegreeNodes);
+                frame->mis.unfoldHypernodes(zeroDegreeNodes, *frame->leftMis);
+                finalMis = frame->leftMis;
+                graph.undo(frame->trailMark);
+            } else if (finalMis->size() > frame->leftMis->size()) {
+                delete frame->leftMis;
+            } else {
+                delete finalMis;
+                finalMis = frame->leftMis;
+            }
+            delete frame;
+            frames.pop_back();
+            continue;
+        }
+        graph.undo(frame->trailMark);
+        frame->restore(*searchNode);
+        searchNode->enterChild();
+        searchNode->lowerBound = getRightLowerBound(frame->branchingRule.type, frame->lowerBound, frame->leftMis->size());
+        branchRight(frame->branchingRule, searchNode, frame->mis);
+        searchNodes++;
+        down = true;
+    }
+    cout << searchNodes << " search nodes, " << prunedSearchNodes << " pruned\n";
+    return finalMis;
+}
+
+/* Same search as runWithCopies(), by options.threads workers. Both children of a search node are created at once,
+ * so they can be solved in parallel, and the right child is only given the parent's lower bound. Lower bounds do not
+ * depend on the order in which tasks are solved, and neither does the choice between two children's mis, so the
+ * final mis is the same for any number of workers */
+vector<uint32_t> *Alg::runParallel() {
+    ParallelSearch search(options.threads, options.stats);
+    search.push(0, new Task(new SearchNode(*searchTree[0]), NULL, true));
+    vector<thread> threads;
+    for (uint32_t i = 1 ; i < options.threads ; i++) {
+        threads.push_back(thread(&Alg::work, this, ref(search), i));
+    }
+    work(search, 0);
+    for (auto &t: threads) {
+        t.join();
+    }
+    uint32_t searchNodes = 0;
+    uint32_t prunedSearchNodes = 0;
+    for (auto worker: search.workers) {
+        searchNodes += worker->searchNodes;
+        prunedSearchNodes += worker->prunedSearchNodes;
+        bounds.mergeStats(worker->bounds);
+        solutionCache.mergeStats(worker->solutionCache);
+    }
+    cout << searchNodes << " search nodes, " << prunedSearchNodes << " pruned\n";
+    return search.finalMis;
+}
+
+void Alg::work(ParallelSearch &search, const uint32_t &worker) {
+    while (true) {
+        Task *task = search.take(worker);
+        if (task != NULL) {
+            expand(search, worker, task);
+        } else if (!search.waitForTasks()) {
+            return;
+        }
+    }
+}
+
+/* Reduce a task's search node and choose its branching rule, then queue its children, or complete it if it is a leaf */
+void Alg::expand(ParallelSearch &search, const uint32_t &worker, Task *task) {
+    Worker &w = *search.workers[worker];
+    SearchNode *searchNode = task->searchNode;
+    w.searchNodes++;
+    if (prune(searchNode, true, w.bounds)) {
+        w.prunedSearchNodes++;
+    } else if (searchNode->theta == 5 && !searchNode->hasCut && searchNode->handleCuts()) {
+        ;
+    } else {
+        searchNode->reductions->run(searchNode->theta);
+        if (prune(searchNode, false, w.bounds)) {
+            w.prunedSearchNodes++;
+        } else if (searchNode->handleComponents() || searchNode->handleSmallGraph(w.solutionCache)) {
+            ;
+        } else {
+            searchNode->branchingRule.choose(searchNode->graph, *(searchNode->reductions), searchNode->theta, searchNode);
+        }
+    }
+    if (searchNode->branchingRule.type == BranchingRule::Type::DONE || searchNode->branchingRule.type == BranchingRule::Type::PRUNED) {
+        vector<uint32_t> *finalMis = new vector<uint32_t>();
+        if (searchNode->branchingRule.type == BranchingRule::Type::DONE) {
+            searchNode->mis.unfoldHypernodes(searchNode->graph.zeroDegreeNodes, *finalMis);
+        }
+        complete(search, worker, task, finalMis);
+    } else if (searchNode->hasCut && searchNode->branchingRule.type != BranchingRule::Type::COMPONENTS) {
+        task->pendingChildren = 1;
+        search.push(worker, createChild(task, true));
+    } else if (searchNode->hasCut) {
+        /* Components do not depend on each other, but the search node is kept to unfold their mis */
+        task->pendingChildren = 2;
+        Task *leftChild = createChild(task, true);
+        Task *rightChild = createChild(task, false);
+        search.push(worker, rightChild);
+        search.push(worker, leftChild);
+    } else {
+        /* Once queued, the children may complete this task on other workers, so it is not accessed after that */
+        task->pendingChildren = 2;
+        Task *rightChild = createChild(task, false);
+        Task *leftChild = createChild(task, true);
+        delete task->searchNode;
+        task->searchNode = NULL;
+        search.push(worker, rightChild);
+        search.push(worker, leftChild);
+    }
+}
+
+/* Hand a task's final mis over to its parent. If it was the parent's last pending child, combine the children's
+ * mis like chooseMaxMis() and concatMis() do, or create the next child of a cut, and go on with the parent */
+void Alg::complete(ParallelSearch &search, const uint32_t &worker, Task *task, vector<uint32_t> *finalMis) {
+    while (true) {
+        Task *parent = task->parent;
+        bool isLeft = task->isLeft;
+        delete task;
+        if (parent == NULL) {
+            search.finish(finalMis);
+            return;
+        }
+        if (isLeft) {
+            parent->leftMis = finalMis;
+        } else {
+            parent->rightMis = finalMis;
+        }
+        if (parent->pendingChildren.fetch_sub(1) != 1) {
+            return;
+        }
+        SearchNode *searchNode = parent->searchNode;
+        if (searchNode != NULL && searchNode->hasCut) {
+            if (parent->rightMis == NULL) {
+                parent->pendingChildren = 1;
+                search.push(worker, createChild(parent, false));
+                return;
+            }
+            if (!searchNode->cutIsDone) {
+                if (parent->leftMis->size() == parent->rightMis->size()) {
+                    searchNode->branchingRule.type = BranchingRule::Type::CUT_RIGHT_1;
+                } else {
+                    searchNode->branchingRule.type = BranchingRule::Type::CUT_RIGHT_2;
+                }
+                delete parent->rightMis;
+                parent->rightMis = NULL;
+                searchNode->cutIsDone = true;
+                parent->pendingChildren = 1;
+                search.push(worker, createChild(parent, false));
+                return;
+            }
+            finalMis = parent->leftMis;
+            finalMis->insert(finalMis->end(), parent->rightMis->begin(), parent->rightMis->end());
+            delete parent->rightMis;
+            searchNode->graph.collectZeroDegreeNodes();
+            searchNode->mis.unfoldHypernodes(searchNode->graph.zeroDegreeNodes, *finalMis);
+        } else if (parent->rightMis->size() > parent->leftMis->size()) {
+            delete parent->leftMis;
+            finalMis = parent->rightMis;
+        } else {
+            delete parent->rightMis;
+            finalMis = parent->leftMis;
+        }
+        {
+            lock_guard<mutex> lock(search.outputMutex);
+            if (parent->depth < search.minCompletedDepth) {
+                search.minCompletedDepth = parent->depth;
+                cout << parent->depth << endl;
+            }
+        }
+        task = parent;
+    }
+}
+
+/* The right child of a cut depends on the left child's mis, while for other branching rules
+ * the right child is created before the left one is solved, and gets only the parent's lower bound.
+ * Components need their exact mis either way */
+Alg::Task *Alg::createChild(Task *task, const bool &isLeft) const {
+    SearchNode *parent = task->searchNode;
+    SearchNode *child = new SearchNode(*parent);
+    if (isLeft) {
+        child->lowerBound = getLeftLowerBound(parent->branchingRule.type, parent->lowerBound);
+        branchLeft(parent->branchingRule, child, parent->mis);
+    } else {
+        if (!parent->hasCut) {
+            child->lowerBound = parent->lowerBound;
+        } else if (parent->branchingRule.type == BranchingRule::Type::COMPONENTS) {
+            child->lowerBound = NONE;
+        } else {
+            child->lowerBound = getRightLowerBound(parent->branchingRule.type, parent->lowerBound, task->leftMis->size());
+        }
+        branchRight(parent->branchingRule, child, parent->mis);
+    }
+    return new Task(child, task, isLeft);
+}
+
+void Alg::ParallelSearch::push(const uint32_t &worker, Task *task) {
+    {
+        lock_guard<mutex> lock(workers[worker]->mutex);
+        queuedTasks++;
+        workers[worker]->tasks.push_back(task);
+    }
+    if (idleWorkers > 0) {
+        lock_guard<mutex> lock(idleMutex);
+        idleCondition.notify_one();
+    }
+}
+
+/* Take the newest task of the worker's own deque, or else steal the oldest task of another worker's deque */
+Alg::Task *Alg::ParallelSearch::take(const uint32_t &worker) {
+    for (uint32_t i = 0 ; i < workers.size() ; i++) {
+        Worker *victim = workers[(worker + i) % workers.size()];
+        lock_guard<mutex> lock(victim->mutex);
+        if (!victim->tasks.empty()) {
+            Task *task;
+            if (!i) {
+                task = victim->tasks.back();
+                victim->tasks.pop_back();
+            } else {
+                task = victim->tasks.front();
+                victim->tasks.pop_front();
+            }
+            queuedTasks--;
+            return task;
+        }
+    }
+    return NULL;
+}
+
+/* Sleep until some task is queued, or the search is done. Return false in the latter case */
+bool Alg::ParallelSearch::waitForTasks() {
+    idleWorkers++;
+    unique_lock<mutex> lock(idleMutex);
+    idleCondition.wait(lock, [this] { return queuedTasks > 0 || done; });
+    idleWorkers--;
+    return !done;
+}
+
+void Alg::ParallelSearch::finish(vector<uint32_t> *mis) {
+    lock_guard<mutex> lock(idleMutex);
+    finalMis = mis;
+    done = true;
+    idleCondition.notify_all();
 }
 
 bool Alg::SearchNode::handleCuts() {
     bool connected;
-    if (graph.getArticulationPoints(cut, c1, c2, actualComponent1, connected) || connected && (graph.getSeparatingPairs(cut, c1, c2, actualComponent1) || graph.getSeparatingTriplets(cut, c1, c2, actualComponent1))) {
+    if (graph.getArticulationPoints(cut, c1, c2, actualComponent1, connected) || connected && (getSeparatingPair() || getSeparatingTriplet())) {
         branchingRule.type = BranchingRule::Type::CUT;
         hasCut = true;
         return true;
@@ -130,6 +496,229 @@ bool Alg::SearchNode::handleCuts() {
     }
 }
 
+/* Find a separation pair that leaves exactly two components, and that the cut branches solve exactly (see isExactCut) */
+bool Alg::SearchNode::getSeparatingPair() {
+    vector<pair<uint32_t, uint32_t> > pairs;
+    graph.findSeparationPairs(pairs);
+    for (auto &separationPair: pairs) {
+        cut.clear();
+        cut.insert(separationPair.first);
+        cut.insert(separationPair.second);
+        if (graph.checkSeparation(cut, c1, c2, actualComponent1) && isExactCut()) {
+            //cout << "Separating pair " << separationPair.first << "-" << separationPair.second << endl;
+            return true;
+        }
+    }
+    cut.clear();
+    c1.clear();
+    c2.clear();
+    return false;
+}
+
+/* Same for 3 node cuts, whose small side checkSeparation limits to Graph::MAX_TRIPLET_SIDE nodes */
+bool Alg::SearchNode::getSeparatingTriplet() {
+    vector<vector<uint32_t> > triplets;
+    graph.findSeparatingTriplets(triplets);
+    for (auto &triplet: triplets) {
+        cut.clear();
+        cut.insert(triplet.begin(), triplet.end());
+        if (graph.checkSeparation(cut, c1, c2, actualComponent1) && isExactCut()) {
+            //cout << "Separating triplet " << triplet[0] << "-" << triplet[1] << "-" << triplet[2] << endl;
+            return true;
+        }
+    }
+    cut.clear();
+    c1.clear();
+    c2.clear();
+    return false;
+}
+
+/* The cut branches take the mis of the component and the rest without the cut nodes, unless the component without the
+ * neighbors of the cut has as large a mis, in which case the cut nodes go with the rest. With a single cut node that is
+ * always exact. With more, a mis may also take some independent subset of the cut and the mis of the component without
+ * its neighbors, so the second case is only exact if taking any such subset loses at least as many nodes in the component.
+ * Check that on the mis of the component, which is solved exactly if it is small enough */
+bool Alg::SearchNode::isExactCut() const {
+    const vector<uint32_t> &component = (actualComponent1 ? c1 : c2);
+    if (component.size() > BitsetSolver::MAX_NODES) {
+        return false;
+    }
+    auto getMisSize = [this, &component](const vector<uint32_t> &cutNodes) {
+        unordered_set<uint32_t> excluded;
+        for (auto node: cutNodes) {
+            graph.gatherNeighbors(node, excluded);
+        }
+        vector<uint32_t> nodes;
+        for (auto node: component) {
+            if (excluded.find(node) == excluded.end()) {
+                nodes.push_back(node);
+            }
+        }
+        BitsetSolver bitsetSolver(graph, nodes);
+        vector<uint32_t> independentSet;
+        bitsetSolver.run(0, independentSet);
+        return (uint32_t) independentSet.size();
+    };
+    vector<uint32_t> cutNodes(cut.begin(), cut.end());
+    uint32_t misSize = getMisSize(vector<uint32_t>());
+    if (getMisSize(cutNodes) == misSize) {
+        return true;
+    }
+    for (uint32_t subset = 1 ; subset < (1u << cutNodes.size()) ; subset++) {
+        vector<uint32_t> subsetNodes;
+        bool independent = true;
+        for (uint32_t i = 0 ; i < cutNodes.size() && independent ; i++) {
+            if (subset & (1u << i)) {
+                for (auto node: subsetNodes) {
+                    if (graph.edgeExists(node, cutNodes[i])) {
+                        independent = false;
+                        break;
+                    }
+                }
+                subsetNodes.push_back(cutNodes[i]);
+            }
+        }
+        if (independent && subsetNodes.size() + getMisSize(subsetNodes) > misSize) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Split off a connected component of the graph. It is solved independently of the rest,
+ * like the components of a cut, and their mis are concatenated */
+bool Alg::SearchNode::handleComponents() {
+    if (!graph.splitComponent(c1, c2)) {
+        return false;
+    }
+    cut.clear();
+    actualComponent1 = true;
+    branchingRule.type = BranchingRule::Type::COMPONENTS;
+    hasCut = true;
+    cutIsDone = true;
+    return true;
+}
+
+/* Solve the blocks of the block-cut tree bottom-up, on the nodes that hang from the top articulation point of each.
+ * With S those nodes and R the rest of the graph, the mis of the graph is a mis of S and one of R if a mis of S - N(a)
+ * is as large as one of S, taking the top a along with R, and otherwise a mis of S and one of R - a. Blocks are folded
+ * while the nodes below them fit in BitsetSolver, and the rest of the tree is left to the search */
+bool Alg::SearchNode::foldBlocks() {
+    Graph::BlockCutTree tree;
+    graph.buildBlockCutTree(tree);
+    vector<uint32_t> memberBlock(graph.nodeIndex.size(), NONE);
+    for (uint32_t block = 0 ; block < tree.getBlocks() ; block++) {
+        for (uint32_t i = tree.blockOffset[block] + 1 ; i < tree.blockOffset[block + 1] ; i++) {
+            memberBlock[graph.getPos(tree.blockNodes[i])] = block;
+        }
+    }
+    vector<bool> foldable(tree.getBlocks(), true);
+    vector<uint32_t> nodes;
+    vector<uint32_t> independentSet;
+    bool folded = false;
+    for (uint32_t block = 0 ; block < tree.getBlocks() ; block++) {
+        uint32_t top = tree.blockTop[block];
+        uint32_t parentBlock = memberBlock[graph.getPos(top)];
+        nodes.clear();
+        for (uint32_t i = tree.blockOffset[block] + 1 ; i < tree.blockOffset[block + 1] ; i++) {
+            if (!graph.nodeIndex[graph.getPos(tree.blockNodes[i])].removed) {
+                nodes.push_back(tree.blockNodes[i]);
+            }
+        }
+        if (!foldable[block] || nodes.size() > BitsetSolver::MAX_NODES) {
+            if (parentBlock != NONE) {
+                foldable[parentBlock] = false;
+            }
+            continue;
+        }
+        if (nodes.empty()) {
+            continue;
+        }
+        BitsetSolver bitsetSolver(graph, nodes);
+        independentSet.clear();
+        bitsetSolver.run(0, independentSet);
+        for (auto &node: independentSet) {
+            node = bitsetSolver.getId(node);
+        }
+        bool removeTop = false;
+        if (!graph.nodeIndex[graph.getPos(top)].removed) {
+            vector<uint32_t> outside;
+            for (auto node: nodes) {
+                if (!graph.edgeExists(node, top)) {
+                    outside.push_back(node);
+                }
+            }
+            vector<uint32_t> outsideSet;
+            if (!outside.empty()) {
+                BitsetSolver outsideSolver(graph, outside);
+                outsideSolver.run(0, outsideSet);
+                for (auto &node: outsideSet) {
+                    node = outsideSolver.getId(node);
+                }
+            }
+            if (outsideSet.size() == independentSet.size()) {
+                independentSet.swap(outsideSet);
+            } else {
+                removeTop = true;
+            }
+        }
+        mis.getMis().insert(mis.getMis().end(), independentSet.begin(), independentSet.end());
+        if (removeTop) {
+            nodes.push_back(top);
+        }
+        graph.remove(nodes, reductions->getReduceInfo());
+        folded = true;
+    }
+    return folded;
+}
+
+/* Solve a small enough graph on an adjacency matrix, instead of branching on it any further, unless its result is cached.
+ * The search node is done if its graph has a large enough mis to beat the lower bound, and pruned otherwise.
+ * The graph is left as is, as done search nodes only need their mis and zero degree nodes */
+bool Alg::SearchNode::handleSmallGraph(SolutionCache &solutionCache) {
+    uint32_t nodes = graph.getNodeCount();
+    if (!nodes || nodes > BitsetSolver::MAX_NODES) {
+        return false;
+    }
+    uint32_t misSize = getMisSize();
+    uint32_t target = (lowerBound == NONE || misSize > lowerBound ? 0 : lowerBound - misSize);
+    BitsetSolver bitsetSolver(graph);
+    vector<uint64_t> key;
+    bool beatsTarget;
+    bitsetSolver.getKey(key);
+    vector<uint32_t> independentSet;
+    if (!solutionCache.find(key, target, independentSet, beatsTarget)) {
+        beatsTarget = bitsetSolver.run(target, independentSet);
+        solutionCache.insert(key, target, independentSet, beatsTarget);
+    }
+    for (auto node: independentSet) {
+        mis.getMis().push_back(bitsetSolver.getId(node));
+    }
+    if (beatsTarget) {
+        branchingRule.type = BranchingRule::Type::DONE;
+    } else {
+        branchingRule.type = BranchingRule::Type::PRUNED;
+    }
+    return true;
+}
+
+/* Prune a search node if an upper bound of its final mis does not exceed its lower bound.
+ * The costlier bounds are only tried after the reductions */
+bool Alg::prune(SearchNode *searchNode, const bool &cheapOnly, Bounds &bounds) {
+    if (searchNode->lowerBound == NONE) {
+        return false;
+    }
+    uint32_t misSize = searchNode->getMisSize();
+    if (misSize > searchNode->lowerBound) {
+        return false;
+    }
+    if (!bounds.isAtMost(searchNode->graph, searchNode->lowerBound - misSize, searchNode->cliqueCover, cheapOnly)) {
+        return false;
+    }
+    searchNode->branchingRule.type = BranchingRule::Type::PRUNED;
+    return true;
+}
+
 void Alg::print() const {
     cout << searchTree.size();
     cout << "\n";
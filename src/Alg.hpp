@@ -1,16 +1,22 @@
 #ifndef ALG_H
 #define ALG_H
 
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include "Graph.hpp"
 #include "Reductions.hpp"
 #include "Mis.hpp"
+#include "Bounds.hpp"
+#include "SolutionCache.hpp"
 
 
 class Alg {
     struct SearchNode;
 
 public:
-    Alg(const std::string &inputFile, const bool &checkIndependentSet);
+    Alg(const std::string &inputFile, const Options &options);
     ~Alg();
     void run();
     const std::vector<SearchNode *> &getSearchTree() const {
@@ -22,7 +28,7 @@ private:
     struct BranchingRule {
     public:
         enum class Type {
-            MAX_DEGREE, SHORT_EDGE, OPTNODE, GOOD_FUNNEL, GOOD_PAIR, FOUR_CYCLE, OPT4NODE, EFFECTIVE_NODE, CUT, CUT_RIGHT_1, CUT_RIGHT_2, DONE
+            MAX_DEGREE, SHORT_EDGE, OPTNODE, GOOD_FUNNEL, GOOD_PAIR, FOUR_CYCLE, OPT4NODE, EFFECTIVE_NODE, CUT, CUT_RIGHT_1, CUT_RIGHT_2, COMPONENTS, DONE, PRUNED
         };
 
         Type type;
@@ -266,7 +272,7 @@ private:
     struct SearchNode {
     public:
         SearchNode(const SearchNode &searchNode, const uint32_t &parent = NONE);
-        SearchNode(const std::string &inputFile, const bool &checkIndependentSet) : id(NONE), graph(inputFile, checkIndependentSet), reductions(new Reductions(graph, mis)), parent(NONE), leftChild(NONE), rightChild(NONE), finalMis(NULL), hasCut(false), cutIsDone(false) {
+        SearchNode(const std::string &inputFile, const Options &options, std::vector<uint32_t> &inputIds) : id(NONE), graph(inputFile, options, inputIds), reductions(new Reductions(graph, mis)), parent(NONE), leftChild(NONE), rightChild(NONE), finalMis(NULL), lowerBound(NONE), hasCut(false), actualComponent1(false), cutIsDone(false) {
             uint32_t maxDegreeNode;
             graph.getMaxNodeDegree(maxDegreeNode, theta);
             if (theta > 8) {
@@ -276,11 +282,31 @@ private:
             }
         }
         ~SearchNode();
+        /* Reset the fields that a newly created child would not inherit, when a node is reused
+         * as its own child by the trail engine */
+        void enterChild() {
+            id = NONE;
+            branchingRule = BranchingRule();
+            reductions->getReduceInfo() = ReduceInfo();
+            hasCut = false;
+            cutIsDone = false;
+        }
         const Graph &getGraph() const {
             return graph;
         }
         void print() const;
         bool handleCuts();
+        bool getSeparatingPair();
+        bool getSeparatingTriplet();
+        bool isExactCut() const;
+        bool handleComponents();
+        bool foldBlocks();
+        bool handleSmallGraph(SolutionCache &solutionCache);
+        /* Apart from the remaining graph, the final mis has the current mis, the zero degree nodes,
+         * and the extra nodes of unfolding */
+        uint32_t getMisSize() {
+            return mis.getMis().size() + mis.getExtraNodes() + graph.zeroDegreeNodes.size();
+        }
 
         uint32_t id;
         uint32_t theta;
@@ -293,6 +319,11 @@ private:
         uint32_t rightChild;
         std::vector<uint32_t> *finalMis; // Final mis of children search nodes, no hypernodes
 
+        /* The final mis is only of use if it is larger than lowerBound, so the search node can be
+         * pruned when an upper bound of it is not. NONE for search nodes that need the exact mis */
+        uint32_t lowerBound;
+        std::shared_ptr<const CliqueCover> cliqueCover; // Of this search node's graph or an ancestor's
+
         bool hasCut;
         std::unordered_set<uint32_t> cut;
         std::vector<uint32_t> c1, c2;
@@ -300,6 +331,139 @@ private:
         bool cutIsDone;
     };
 
+    /* What the trail engine keeps for each search node on the current path, instead of a SearchNode.
+     * The graph is not kept, only the trail mark to return to its state */
+    struct Frame {
+    public:
+        Frame(const SearchNode &searchNode, const size_t &trailMark) : theta(searchNode.theta), branchingRule(searchNode.branchingRule), mis(searchNode.mis),
+            trailMark(trailMark), lowerBound(searchNode.lowerBound), cliqueCover(searchNode.cliqueCover), hasCut(searchNode.hasCut), cutIsDone(searchNode.cutIsDone), leftMis(NULL) {
+            if (hasCut) {
+                cut = searchNode.cut;
+                c1 = searchNode.c1;
+                c2 = searchNode.c2;
+                actualComponent1 = searchNode.actualComponent1;
+            }
+        }
+
+        /* Bring the reused search node back to this one's state, except for the graph */
+        void restore(SearchNode &searchNode) const {
+            searchNode.theta = theta;
+            searchNode.mis = mis;
+            searchNode.cliqueCover = cliqueCover;
+            if (hasCut) {
+                searchNode.cut = cut;
+                searchNode.c1 = c1;
+                searchNode.c2 = c2;
+                searchNode.actualComponent1 = actualComponent1;
+            }
+        }
+
+        uint32_t theta;
+        BranchingRule branchingRule;
+        Mis mis;
+        size_t trailMark;
+        uint32_t lowerBound;
+        std::shared_ptr<const CliqueCover> cliqueCover;
+        bool hasCut;
+        std::unordered_set<uint32_t> cut;
+        std::vector<uint32_t> c1, c2;
+        bool actualComponent1;
+        bool cutIsDone;
+        std::vector<uint32_t> *leftMis; // Final mis of the left child, once it is done
+    };
+
+    /* A search node of the parallel engine. Its children may be solved by different workers, and the last one
+     * to finish combines their final mis and completes this one in turn. Cut children are created one at a time,
+     * as each one depends on the previous one's mis */
+    struct Task {
+    public:
+        Task(SearchNode *searchNode, Task *parent, const bool &isLeft) : searchNode(searchNode), parent(parent), isLeft(isLeft),
+            depth(parent == NULL ? 0 : parent->depth + 1), leftMis(NULL), rightMis(NULL), pendingChildren(0) {}
+        ~Task() {
+            delete searchNode;
+        }
+
+        SearchNode *searchNode; // Released once both children are created, unless it has a cut
+        Task *parent;
+        bool isLeft;
+        uint32_t depth;
+        std::vector<uint32_t> *leftMis;
+        std::vector<uint32_t> *rightMis;
+        std::atomic<uint32_t> pendingChildren;
+    };
+
+    /* A thread of the parallel engine. It takes tasks from the back of its own deque, which keeps its search
+     * depth first, and idle workers steal from the front, where the tasks closest to the root are */
+    struct Worker {
+    public:
+        Worker(const bool &stats) : bounds(stats), searchNodes(0), prunedSearchNodes(0) {}
+
+        std::deque<Task *> tasks;
+        std::mutex mutex;
+        Bounds bounds;
+        SolutionCache solutionCache;
+        uint32_t searchNodes;
+        uint32_t prunedSearchNodes;
+    };
+
+    /* State shared by the workers of the parallel engine */
+    struct ParallelSearch {
+    public:
+        ParallelSearch(const uint32_t &threads, const bool &stats) : queuedTasks(0), idleWorkers(0), done(false), finalMis(NULL), minCompletedDepth(NONE) {
+            for (uint32_t i = 0 ; i < threads ; i++) {
+                workers.push_back(new Worker(stats));
+            }
+        }
+        ~ParallelSearch() {
+            for (auto worker: workers) {
+                delete worker;
+            }
+        }
+        void push(const uint32_t &worker, Task *task);
+        Task *take(const uint32_t &worker);
+        bool waitForTasks();
+        void finish(std::vector<uint32_t> *mis);
+
+        std::vector<Worker *> workers;
+        std::atomic<uint32_t> queuedTasks;
+        std::atomic<uint32_t> idleWorkers;
+        bool done;
+        std::mutex idleMutex;
+        std::condition_variable idleCondition;
+        std::vector<uint32_t> *finalMis;
+        uint32_t minCompletedDepth;
+        std::mutex outputMutex;
+    };
+
+    std::vector<uint32_t> *runWithCopies();
+    std::vector<uint32_t> *runWithTrail();
+    std::vector<uint32_t> *runParallel();
+    void work(ParallelSearch &search, const uint32_t &worker);
+    void expand(ParallelSearch &search, const uint32_t &worker, Task *task);
+    void complete(ParallelSearch &search, const uint32_t &worker, Task *task, std::vector<uint32_t> *finalMis);
+    Task *createChild(Task *task, const bool &isLeft) const;
+    bool prune(SearchNode *searchNode, const bool &cheapOnly, Bounds &bounds);
+
+    /* Left children are needed only if they beat the parent's lower bound, and right children
+     * only if they also beat the left child's mis. Cut and component branches solve components independently,
+     * which need their exact mis, except for the first right branch of a cut, which is only compared to the left one */
+    static uint32_t getLeftLowerBound(const BranchingRule::Type &type, const uint32_t &lowerBound) {
+        return (type == BranchingRule::Type::CUT || type == BranchingRule::Type::COMPONENTS ? NONE : lowerBound);
+    }
+
+    static uint32_t getRightLowerBound(const BranchingRule::Type &type, const uint32_t &lowerBound, const uint32_t &leftMisSize) {
+        switch (type) {
+            case BranchingRule::Type::CUT:
+                return (leftMisSize ? leftMisSize - 1 : NONE);
+            case BranchingRule::Type::CUT_RIGHT_1:
+            case BranchingRule::Type::CUT_RIGHT_2:
+            case BranchingRule::Type::COMPONENTS:
+                return NONE;
+            default:
+                return (lowerBound == NONE || leftMisSize > lowerBound ? leftMisSize : lowerBound);
+        }
+    }
+
 
     void chooseMaxMis(SearchNode *parent) {
         //std::cout << "no next child" << std::endl;
@@ -395,6 +559,10 @@ private:
                 searchNode->graph.remove(nonAdjacent, searchNode->reductions->getReduceInfo());
                 break;
             }
+            case BranchingRule::Type::COMPONENTS: {
+                keepComponent(searchNode, searchNode->c1, parentMis);
+                break;
+            }
             case BranchingRule::Type::CUT: {
                 //std::cout << "left cut" << std::endl;
                 std::vector<uint32_t> *component1 = (searchNode->actualComponent1 ? &(searchNode->c1) : &(searchNode->c2));
@@ -415,9 +583,8 @@ private:
             default:
                 assert(false);
         }
-        uint32_t dummy, maxDegree;
+        uint32_t maxDegree = searchNode->graph.getMaxDegree();
         uint32_t oldTheta = searchNode->theta;
-        searchNode->graph.getMaxNodeDegree(dummy, maxDegree, oldTheta);
         if (maxDegree < oldTheta) {
             if (maxDegree >= 3) {
                 searchNode->theta = maxDegree;
@@ -444,6 +611,7 @@ private:
                 searchNode->graph.gatherNeighbors(branchingRule.node1, neighbors1);
                 searchNode->graph.gatherNeighbors(branchingRule.node2, neighbors2);
                 std::unordered_map<uint32_t, uint32_t> &subsequentNodes = searchNode->mis.getSubsequentNodes();
+                searchNode->mis.addExtraNodes(1);
                 for (auto neighbor1: neighbors1) {
                     subsequentNodes.insert({neighbor1, branchingRule.node2});
                     searchNode->graph.addEdges(neighbor1, neighbors2);
@@ -518,6 +686,10 @@ private:
                 parentMis.removeHypernodes(searchNode->mis.getHypernodeToInnerNode());
                 break;
             }
+            case BranchingRule::Type::COMPONENTS: {
+                keepComponent(searchNode, searchNode->c2, parentMis);
+                break;
+            }
             case BranchingRule::Type::CUT_RIGHT_2: {
                 //std::cout << "right cut 2" << std::endl;
                 std::vector<uint32_t> *component1 = (searchNode->actualComponent1 ? &(searchNode->c1) : &(searchNode->c2));
@@ -538,9 +710,8 @@ private:
             default:
                 assert(false);
         }
-        uint32_t dummy, maxDegree;
+        uint32_t maxDegree = searchNode->graph.getMaxDegree();
         uint32_t oldTheta = searchNode->theta;
-        searchNode->graph.getMaxNodeDegree(dummy, maxDegree, oldTheta);
         if (maxDegree < oldTheta) {
             if (maxDegree >= 3) {
                 searchNode->theta = maxDegree;
@@ -550,6 +721,16 @@ private:
         }
     }
 
+    /* Reduce a search node to one of its graph's connected components. The hypernodes of the component
+     * are unfolded by the search node, and the rest of them by the parent */
+    void keepComponent(SearchNode *searchNode, const std::vector<uint32_t> &component, Mis &parentMis) const {
+        std::unordered_set<uint32_t> nodesInComponent(component.begin(), component.end());
+        searchNode->graph.rebuildFromNodes(nodesInComponent);
+        searchNode->mis.getMis().clear();
+        searchNode->mis.keepHypernodes(component);
+        parentMis.removeHypernodes(searchNode->mis.getHypernodeToInnerNode());
+    }
+
     void branchOnExtendedGranchildren(const BranchingRule &branchingRule, SearchNode *searchNode) const {
         std::unordered_set<uint32_t> extendedGrandchildren;
         Graph::GraphTraversal graphTraversal(searchNode->graph, branchingRule.node1);
@@ -572,6 +753,9 @@ private:
     }
 
     std::vector<SearchNode *> searchTree;
+    Options options;
+    Bounds bounds;
+    SolutionCache solutionCache;
 };
 
 
@@ -0,0 +1,223 @@
+#include "BitsetSolver.hpp"
+
+using namespace std;
+
+/* Nodes are numbered by descending degree, which the greedy clique cover visits in that order. Nodes of equal degree
+ * are ordered by color refinement: the colors of their neighbors, then the colors of their neighbors' neighbors, and so on.
+ * The order does not depend on node ids wherever refinement tells nodes apart, so isomorphic graphs mostly get the same
+ * matrix, which SolutionCache relies on. Only the nodes that it does not tell apart are ordered by id */
+BitsetSolver::BitsetSolver(const Graph &graph) : bestSize(0) {
+    vector<uint32_t> positions;
+    for (uint32_t pos = 0 ; pos < graph.nodeIndex.size() ; pos++) {
+        if (!graph.nodeIndex[pos].removed) {
+            positions.push_back(pos);
+        }
+    }
+    build(graph, positions);
+}
+
+/* The subgraph induced by some nodes of the graph, given by id */
+BitsetSolver::BitsetSolver(const Graph &graph, const vector<uint32_t> &subgraphNodes) : bestSize(0) {
+    vector<uint32_t> positions;
+    for (auto node: subgraphNodes) {
+        positions.push_back(graph.getPos(node));
+    }
+    build(graph, positions);
+}
+
+void BitsetSolver::build(const Graph &graph, const vector<uint32_t> &positions) {
+    nodes = positions.size();
+    words = (nodes + 63) / 64;
+    vector<uint32_t> nodeOfPos(graph.nodeIndex.size(), NONE);
+    for (uint32_t node = 0 ; node < nodes ; node++) {
+        nodeOfPos[positions[node]] = node;
+    }
+    vector<vector<uint32_t> > neighbors(nodes);
+    for (uint32_t node = 0 ; node < nodes ; node++) {
+        uint32_t pos = positions[node];
+        uint32_t nextNodeOffset = graph.getSlotEnd(pos);
+        for (uint32_t offset = graph.nodeIndex[pos].offset ; offset < nextNodeOffset ; offset++) {
+            uint32_t neighbor = nodeOfPos[graph.getPos((*graph.edgeBuffer)[offset])];
+            if (neighbor != NONE) {
+                neighbors[node].push_back(neighbor);
+            }
+        }
+    }
+
+    vector<uint32_t> order(nodes);
+    vector<uint32_t> color(nodes);
+    vector<vector<uint32_t> > signature(nodes);
+    for (uint32_t node = 0 ; node < nodes ; node++) {
+        order[node] = node;
+        signature[node].push_back(NONE - neighbors[node].size());
+    }
+    uint32_t colors = 0;
+    while (true) {
+        sort(order.begin(), order.end(), [&signature](const uint32_t &node1, const uint32_t &node2) {
+            return signature[node1] < signature[node2];
+        });
+        uint32_t newColors = 0;
+        for (uint32_t i = 0 ; i < nodes ; i++) {
+            if (i && signature[order[i]] != signature[order[i-1]]) {
+                newColors++;
+            }
+            color[order[i]] = newColors;
+        }
+        if (++newColors == colors) {
+            break;
+        }
+        colors = newColors;
+        for (uint32_t node = 0 ; node < nodes ; node++) {
+            signature[node].assign(1, color[node]);
+            for (auto neighbor: neighbors[node]) {
+                signature[node].push_back(color[neighbor]);
+            }
+            sort(signature[node].begin() + 1, signature[node].end());
+        }
+    }
+    ids.resize(nodes);
+    for (uint32_t node = 0 ; node < nodes ; node++) {
+        ids[node] = graph.getNode(positions[node]);
+    }
+    sort(order.begin(), order.end(), [&color, this](const uint32_t &node1, const uint32_t &node2) {
+        return (color[node1] != color[node2] ? color[node1] < color[node2] : ids[node1] < ids[node2]);
+    });
+
+    vector<uint32_t> index(nodes);
+    for (uint32_t i = 0 ; i < nodes ; i++) {
+        index[order[i]] = i;
+    }
+    adjacency.assign(nodes * words, 0);
+    for (uint32_t node = 0 ; node < nodes ; node++) {
+        uint64_t *row = getNeighbors(index[node]);
+        for (auto neighbor: neighbors[node]) {
+            row[index[neighbor] >> 6] |= 1ULL << (index[neighbor] & 63);
+        }
+    }
+    vector<uint32_t> nodeIds(nodes);
+    for (uint32_t node = 0 ; node < nodes ; node++) {
+        nodeIds[index[node]] = ids[node];
+    }
+    ids.swap(nodeIds);
+    candidates.assign((nodes + 1) * words, 0);
+    scratch.assign(2 * words, 0);
+}
+
+/* The adjacency matrix, which identifies the graph up to isomorphism for SolutionCache */
+void BitsetSolver::getKey(vector<uint64_t> &key) const {
+    key.reserve(adjacency.size() + 1);
+    key.assign(1, nodes);
+    key.insert(key.end(), adjacency.begin(), adjacency.end());
+}
+
+/* Find an independent set larger than target, which is the maximum one if there is any,
+ * and append its nodes to independentSet, as indexes of the matrix */
+bool BitsetSolver::run(const uint32_t &target, vector<uint32_t> &independentSet) {
+    uint64_t *all = getCandidates(0);
+    for (uint32_t node = 0 ; node < nodes ; node++) {
+        all[node >> 6] |= 1ULL << (node & 63);
+    }
+    bestSize = target;
+    best.clear();
+    current.clear();
+    search(0);
+    if (bestSize == target) {
+        return false;
+    }
+    independentSet.insert(independentSet.end(), best.begin(), best.end());
+    return true;
+}
+
+/* Take nodes of degree 0 or 1, which are in some maximum independent set, then prune with a clique cover
+ * or branch on a node of maximum degree, taking it and its neighbors out or only itself */
+void BitsetSolver::search(const uint32_t &depth) {
+    uint64_t *set = getCandidates(depth);
+    uint32_t taken = current.size();
+    uint32_t branchNode = NONE;
+    bool reduced = true;
+    while (reduced) {
+        reduced = false;
+        branchNode = NONE;
+        uint32_t maxDegree = 0;
+        for (uint32_t i = 0 ; i < words ; i++) {
+            uint64_t word = set[i];
+            while (word) {
+                uint32_t node = (i << 6) + __builtin_ctzll(word);
+                word &= word - 1;
+                uint32_t degree = getDegree(node, set);
+                if (degree <= 1) {
+                    current.push_back(node);
+                    erase(set, node);
+                    if (degree) {
+                        const uint64_t *neighbors = getNeighbors(node);
+                        for (uint32_t j = 0 ; j < words ; j++) {
+                            set[j] &= ~neighbors[j];
+                        }
+                    }
+                    word &= set[i];
+                    reduced = true;
+                } else if (branchNode == NONE || degree > maxDegree) {
+                    branchNode = node;
+                    maxDegree = degree;
+                }
+            }
+        }
+    }
+    if (branchNode == NONE) {
+        if (current.size() > bestSize) {
+            bestSize = current.size();
+            best = current;
+        }
+        current.resize(taken);
+        return;
+    }
+    if (current.size() + getCliqueCoverBound(set, &scratch[0]) <= bestSize) {
+        current.resize(taken);
+        return;
+    }
+
+    uint64_t *next = getCandidates(depth + 1);
+    const uint64_t *neighbors = getNeighbors(branchNode);
+    for (uint32_t i = 0 ; i < words ; i++) {
+        next[i] = set[i] & ~neighbors[i];
+    }
+    erase(next, branchNode);
+    current.push_back(branchNode);
+    search(depth + 1);
+    current.pop_back();
+
+    copy(set, set + words, next);
+    erase(next, branchNode);
+    search(depth + 1);
+    current.resize(taken);
+}
+
+/* Greedy clique cover of a set, as in Bounds::getCliqueCoverBound, but growing one clique at a time
+ * by intersecting the neighborhoods of its nodes. remaining is scratch space of 2 * words */
+uint32_t BitsetSolver::getCliqueCoverBound(const uint64_t *set, uint64_t *remaining) const {
+    uint64_t *clique = remaining + words;
+    copy(set, set + words, remaining);
+    uint32_t cliques = 0;
+    for (uint32_t i = 0 ; i < words ; i++) {
+        while (remaining[i]) {
+            uint32_t node = (i << 6) + __builtin_ctzll(remaining[i]);
+            erase(remaining, node);
+            cliques++;
+            const uint64_t *neighbors = getNeighbors(node);
+            for (uint32_t j = i ; j < words ; j++) {
+                clique[j] = remaining[j] & neighbors[j];
+            }
+            for (uint32_t j = i ; j < words ; j++) {
+                while (clique[j]) {
+                    uint32_t member = (j << 6) + __builtin_ctzll(clique[j]);
+                    erase(remaining, member);
+                    const uint64_t *memberNeighbors = getNeighbors(member);
+                    for (uint32_t k = j ; k < words ; k++) {
+                        clique[k] &= memberNeighbors[k];
+                    }
+                }
+            }
+        }
+    }
+    return cliques;
+}
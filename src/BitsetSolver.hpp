@@ -0,0 +1,63 @@
+#ifndef BITSET_SOLVER_H
+#define BITSET_SOLVER_H
+
+#include "Graph.hpp"
+
+/* Exact branch and reduce for small graphs, on an adjacency matrix of 64 bit words instead of the
+ * edge buffer. Sets of nodes are bitsets, so that neighborhoods are intersected, counted and removed
+ * a word at a time. Each node of the matrix is mapped back to its id in the graph with getId() */
+class BitsetSolver {
+public:
+    /* Largest graph converted to a matrix. Larger sparse graphs are solved faster by the reductions of the search */
+    static const uint32_t MAX_NODES = 128;
+
+    BitsetSolver(const Graph &graph);
+    BitsetSolver(const Graph &graph, const std::vector<uint32_t> &subgraphNodes);
+    void getKey(std::vector<uint64_t> &key) const;
+    bool run(const uint32_t &target, std::vector<uint32_t> &independentSet);
+    const uint32_t &getId(const uint32_t &node) const {
+        return ids[node];
+    }
+
+private:
+    void build(const Graph &graph, const std::vector<uint32_t> &positions);
+    void search(const uint32_t &depth);
+    uint32_t getCliqueCoverBound(const uint64_t *set, uint64_t *remaining) const;
+
+    uint64_t *getNeighbors(const uint32_t &node) {
+        return &adjacency[node * words];
+    }
+    const uint64_t *getNeighbors(const uint32_t &node) const {
+        return &adjacency[node * words];
+    }
+    /* Candidate nodes at each search depth */
+    uint64_t *getCandidates(const uint32_t &depth) {
+        return &candidates[depth * words];
+    }
+    uint32_t getDegree(const uint32_t &node, const uint64_t *set) const {
+        const uint64_t *neighbors = getNeighbors(node);
+        uint32_t degree = 0;
+        for (uint32_t i = 0 ; i < words ; i++) {
+            degree += __builtin_popcountll(neighbors[i] & set[i]);
+        }
+        return degree;
+    }
+    static bool contains(const uint64_t *set, const uint32_t &node) {
+        return set[node >> 6] & (1ULL << (node & 63));
+    }
+    static void erase(uint64_t *set, const uint32_t &node) {
+        set[node >> 6] &= ~(1ULL << (node & 63));
+    }
+
+    uint32_t nodes;
+    uint32_t words;
+    std::vector<uint32_t> ids;
+    std::vector<uint64_t> adjacency;
+    std::vector<uint64_t> candidates;
+    std::vector<uint64_t> scratch;
+    std::vector<uint32_t> current; // Nodes taken on the current search path
+    std::vector<uint32_t> best;
+    uint32_t bestSize;
+};
+
+#endif
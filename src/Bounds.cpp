@@ -0,0 +1,198 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include "Bounds.hpp"
+
+using namespace std;
+
+/* Check whether the independence number of graph is at most target, trying the cheapest bounds first.
+ * cliqueCover is the cover inherited from the parent search node, if any, and is replaced with
+ * a new one whenever the greedy clique cover is computed, to be inherited by the children */
+bool Bounds::isAtMost(const Graph &graph, const uint32_t &target, shared_ptr<const CliqueCover> &cliqueCover, const bool &cheapOnly) {
+    const uint32_t count = (uint32_t) Type::COUNT;
+    uint32_t bounds[count];
+    bool evaluated[count] = {false};
+    uint32_t pruningBound = count;
+    uint32_t nodes = (evaluateAll ? graph.getNodeCount() : 0);
+    shared_ptr<CliqueCover> newCliqueCover;
+    for (uint32_t i = 0 ; i < count && (pruningBound == count || evaluateAll) ; i++) {
+        Type type = (Type) i;
+        if (type == Type::INCREMENTAL_CLIQUE_COVER && cliqueCover == nullptr || type == Type::CLIQUE_COVER && cheapOnly) {
+            continue;
+        }
+        auto start = chrono::steady_clock::now();
+        switch (type) {
+            case Type::DEGREE_SEQUENCE:
+                bounds[i] = getDegreeSequenceBound(graph);
+                break;
+            case Type::INCREMENTAL_CLIQUE_COVER:
+                bounds[i] = getIncrementalCliqueCoverBound(graph, *cliqueCover);
+                break;
+            case Type::CLIQUE_COVER:
+                newCliqueCover = make_shared<CliqueCover>();
+                bounds[i] = getCliqueCoverBound(graph, *newCliqueCover);
+                break;
+            default:
+                assert(false);
+        }
+        auto end = chrono::steady_clock::now();
+        evaluated[i] = true;
+        stats[i].calls++;
+        stats[i].nanoseconds += chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+        stats[i].boundSum += bounds[i];
+        stats[i].nodesSum += nodes;
+        if (bounds[i] <= target && pruningBound == count) {
+            pruningBound = i;
+            stats[i].prunes++;
+        }
+    }
+    uint32_t minBound = NONE;
+    for (uint32_t i = 0 ; i < count ; i++) {
+        if (evaluated[i] && bounds[i] < minBound) {
+            minBound = bounds[i];
+        }
+    }
+    for (uint32_t i = 0 ; i < count ; i++) {
+        if (evaluated[i] && bounds[i] == minBound) {
+            stats[i].tightest++;
+        }
+    }
+    if (newCliqueCover != nullptr) {
+        cliqueCover = newCliqueCover;
+    }
+    return pruningBound != count;
+}
+
+/* An independent set of k nodes has k * (their degrees) distinct edges, so the sum of the k
+ * smallest degrees is at most the number of edges. Degrees are read from the graph's degree buckets */
+uint32_t Bounds::getDegreeSequenceBound(const Graph &graph) {
+    uint64_t edges = graph.getTotalEdges() / 2;
+    uint32_t bound = graph.getDegreeCount(0);
+    uint64_t degreeSum = 0;
+    for (uint32_t degree = 1 ; degree <= graph.getMaxDegree() ; degree++) {
+        uint32_t count = graph.getDegreeCount(degree);
+        uint64_t fitting = (edges - degreeSum) / degree;
+        if (fitting < count) {
+            bound += fitting;
+            break;
+        }
+        bound += count;
+        degreeSum += (uint64_t) degree * count;
+    }
+    return bound;
+}
+
+/* Reductions and branching only remove nodes, add edges, or add new nodes, so two remaining nodes
+ * of an ancestor's clique are still adjacent. The ancestor's cover, restricted to the remaining nodes,
+ * along with a single node clique for each new node, is a clique cover without examining any edges */
+uint32_t Bounds::getIncrementalCliqueCoverBound(const Graph &graph, const CliqueCover &cliqueCover) {
+    uint32_t cliques = 0;
+    vector<bool> usedClique(cliqueCover.cliques, false);
+    for (uint32_t pos = 0 ; pos < graph.nodeIndex.size() ; pos++) {
+        if (graph.nodeIndex[pos].removed) {
+            continue;
+        }
+        uint32_t node = graph.getNode(pos);
+        uint32_t clique = (node < cliqueCover.cliqueOfNode.size() ? cliqueCover.cliqueOfNode[node] : NONE);
+        if (clique == NONE) {
+            cliques++;
+        } else if (!usedClique[clique]) {
+            usedClique[clique] = true;
+            cliques++;
+        }
+    }
+    return cliques;
+}
+
+/* Visit nodes by descending degree, adding each one to the largest clique that it is adjacent to
+ * entirely, or to a new one. Neighbors in each clique are counted in a single pass of the node's edges */
+uint32_t Bounds::getCliqueCoverBound(const Graph &graph, CliqueCover &cliqueCover) {
+    uint32_t maxDegree = 0;
+    for (uint32_t pos = 0 ; pos < graph.nodeIndex.size() ; pos++) {
+        if (!graph.nodeIndex[pos].removed && graph.nodeIndex[pos].edges > maxDegree) {
+            maxDegree = graph.nodeIndex[pos].edges;
+        }
+    }
+    vector<uint32_t> degreeStart(maxDegree + 2, 0);
+    for (uint32_t pos = 0 ; pos < graph.nodeIndex.size() ; pos++) {
+        if (!graph.nodeIndex[pos].removed) {
+            degreeStart[maxDegree - graph.nodeIndex[pos].edges + 1]++;
+        }
+    }
+    for (uint32_t i = 1 ; i < degreeStart.size() ; i++) {
+        degreeStart[i] += degreeStart[i-1];
+    }
+    vector<uint32_t> order(degreeStart.back());
+    for (uint32_t pos = 0 ; pos < graph.nodeIndex.size() ; pos++) {
+        if (!graph.nodeIndex[pos].removed) {
+            order[degreeStart[maxDegree - graph.nodeIndex[pos].edges]++] = pos;
+        }
+    }
+
+    vector<uint32_t> cliqueOfPos(graph.nodeIndex.size(), NONE);
+    vector<uint32_t> cliqueSize;
+    vector<uint32_t> neighborsInClique;
+    vector<uint32_t> touchedCliques;
+    for (auto pos: order) {
+        uint32_t nextNodeOffset = graph.getSlotEnd(pos);
+        for (uint32_t offset = graph.nodeIndex[pos].offset ; offset < nextNodeOffset ; offset++) {
+            uint32_t nPos = graph.getPos((*graph.edgeBuffer)[offset]);
+            uint32_t clique = cliqueOfPos[nPos];
+            if (graph.nodeIndex[nPos].removed || clique == NONE) {
+                continue;
+            }
+            if (!neighborsInClique[clique]++) {
+                touchedCliques.push_back(clique);
+            }
+        }
+        uint32_t bestClique = NONE;
+        for (auto clique: touchedCliques) {
+            if (neighborsInClique[clique] == cliqueSize[clique] && (bestClique == NONE || cliqueSize[clique] > cliqueSize[bestClique])) {
+                bestClique = clique;
+            }
+            neighborsInClique[clique] = 0;
+        }
+        touchedCliques.clear();
+        if (bestClique == NONE) {
+            bestClique = cliqueSize.size();
+            cliqueSize.push_back(0);
+            neighborsInClique.push_back(0);
+        }
+        cliqueOfPos[pos] = bestClique;
+        cliqueSize[bestClique]++;
+    }
+
+    cliqueCover.cliques = cliqueSize.size();
+    cliqueCover.cliqueOfNode.assign(graph.nextUnusedId, NONE);
+    for (auto pos: order) {
+        uint32_t node = graph.getNode(pos);
+        if (node >= cliqueCover.cliqueOfNode.size()) {
+            cliqueCover.cliqueOfNode.resize(node + 1, NONE);
+        }
+        cliqueCover.cliqueOfNode[node] = cliqueOfPos[pos];
+    }
+    return cliqueCover.cliques;
+}
+
+/* Add the stats of another Bounds, such as one of a parallel worker */
+void Bounds::mergeStats(const Bounds &bounds) {
+    for (uint32_t i = 0 ; i < (uint32_t) Type::COUNT ; i++) {
+        stats[i].calls += bounds.stats[i].calls;
+        stats[i].prunes += bounds.stats[i].prunes;
+        stats[i].tightest += bounds.stats[i].tightest;
+        stats[i].nanoseconds += bounds.stats[i].nanoseconds;
+        stats[i].boundSum += bounds.stats[i].boundSum;
+        stats[i].nodesSum += bounds.stats[i].nodesSum;
+    }
+}
+
+void Bounds::printStats() const {
+    const char *names[] = {"degree sequence", "incremental clique cover", "greedy clique cover"};
+    cout << "\n" << left << setw(26) << "Bound" << right << setw(10) << "calls" << setw(10) << "prunes" << setw(10) << "tightest"
+    << setw(12) << "time (ms)" << setw(14) << "bound/nodes" << "\n";
+    for (uint32_t i = 0 ; i < (uint32_t) Type::COUNT ; i++) {
+        const Stats &s = stats[i];
+        cout << left << setw(26) << names[i] << right << setw(10) << s.calls << setw(10) << s.prunes << setw(10) << s.tightest
+        << setw(12) << fixed << setprecision(1) << s.nanoseconds / 1e6 << setw(14) << setprecision(3) << (s.nodesSum ? (double) s.boundSum / s.nodesSum : 0.0) << "\n";
+    }
+}
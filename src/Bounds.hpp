@@ -0,0 +1,50 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <memory>
+#include "Graph.hpp"
+
+/* Clique cover of a graph, as the clique of each node id. A clique cover of size k
+ * (a k-coloring of the complement graph) means that an independent set has at most k nodes */
+struct CliqueCover {
+public:
+    std::vector<uint32_t> cliqueOfNode; // NONE for nodes that were not in the graph
+    uint32_t cliques;
+};
+
+/* Upper bounds on the independence number of a graph, used for pruning search nodes */
+class Bounds {
+public:
+    enum class Type {
+        DEGREE_SEQUENCE, INCREMENTAL_CLIQUE_COVER, CLIQUE_COVER, COUNT
+    };
+
+    Bounds(const bool &evaluateAll = false) : evaluateAll(evaluateAll) {}
+    bool isAtMost(const Graph &graph, const uint32_t &target, std::shared_ptr<const CliqueCover> &cliqueCover, const bool &cheapOnly = false);
+    void mergeStats(const Bounds &bounds);
+    void printStats() const;
+
+    static uint32_t getDegreeSequenceBound(const Graph &graph);
+    static uint32_t getIncrementalCliqueCoverBound(const Graph &graph, const CliqueCover &cliqueCover);
+    static uint32_t getCliqueCoverBound(const Graph &graph, CliqueCover &cliqueCover);
+
+private:
+    /* Cost and tightness of a bound over all of its evaluations */
+    struct Stats {
+    public:
+        Stats() : calls(0), prunes(0), tightest(0), nanoseconds(0), boundSum(0), nodesSum(0) {}
+
+        uint64_t calls;
+        uint64_t prunes; // Times it was the first one to prune
+        uint64_t tightest; // Times it was the lowest among the evaluated bounds
+        uint64_t nanoseconds;
+        uint64_t boundSum;
+        uint64_t nodesSum; // Remaining nodes at each call, to compare the bound against
+    };
+
+    /* Evaluate every bound even after one prunes, for comparing them. Pruning stays the same */
+    bool evaluateAll;
+    Stats stats[(uint32_t) Type::COUNT];
+};
+
+#endif
@@ -8,10 +8,37 @@ using namespace std;
 
 int main(int argc, char **argv) {
     string graphInputFile;
-    bool checkIndependentSet = false;
+    string binaryOutputFile;
+    Options options;
     for (int i=1 ; i < argc ; i++) {
         if (!strcmp(argv[i], "-check")) {
-            checkIndependentSet = true;
+            options.checkIndependentSet = true;
+        } else if (!strcmp(argv[i], "-trail")) {
+            options.trail = true;
+        } else if (!strcmp(argv[i], "-blocks")) {
+            options.blocks = true;
+        } else if (!strcmp(argv[i], "-compact")) {
+            options.compact = true;
+        } else if (!strcmp(argv[i], "-reorder")) {
+            options.reorder = true;
+        } else if (!strcmp(argv[i], "-stats")) {
+            options.stats = true;
+        } else if (!strcmp(argv[i], "-convert")) {
+            if (i + 1 == argc) {
+                cerr << "Error: -convert needs an output file" << endl;
+                exit(EXIT_FAILURE);
+            }
+            binaryOutputFile = argv[++i];
+        } else if (!strcmp(argv[i], "-memory")) {
+            if (i + 1 == argc || !(options.loadMemory = strtoul(argv[++i], NULL, 10))) {
+                cerr << "Error: -memory needs a positive number of megabytes" << endl;
+                exit(EXIT_FAILURE);
+            }
+        } else if (!strcmp(argv[i], "-threads")) {
+            if (i + 1 == argc || !(options.threads = strtoul(argv[++i], NULL, 10))) {
+                cerr << "Error: -threads needs a positive number of threads" << endl;
+                exit(EXIT_FAILURE);
+            }
         } else {
             graphInputFile = argv[i];
         }
@@ -20,8 +47,22 @@ int main(int argc, char **argv) {
        cerr << "Error: No graph input file specified" << endl;
        exit(EXIT_FAILURE);
    }
-   ControlUnit controlUnit(graphInputFile, checkIndependentSet);
-   if (!checkIndependentSet) {
+   if (options.trail && options.threads) {
+       cerr << "Error: -trail and -threads cannot be combined" << endl;
+       exit(EXIT_FAILURE);
+   }
+   if (binaryOutputFile.compare("") && options.checkIndependentSet) {
+       cerr << "Error: -convert and -check cannot be combined" << endl;
+       exit(EXIT_FAILURE);
+   }
+   if (binaryOutputFile.compare("") && (options.compact || options.reorder)) {
+       cerr << "Error: -convert cannot be combined with -compact or -reorder" << endl;
+       exit(EXIT_FAILURE);
+   }
+   ControlUnit controlUnit(graphInputFile, options);
+   if (binaryOutputFile.compare("")) {
+       controlUnit.convert(binaryOutputFile);
+   } else if (!options.checkIndependentSet) {
        controlUnit.run();
    } else {
        controlUnit.checkIndependentSet(graphInputFile + ".mis");
@@ -32,6 +73,10 @@ void ControlUnit::run() {
     alg.run();
 }
 
+void ControlUnit::convert(const string &binaryOutputFile) const {
+    alg.getSearchTree()[0]->getGraph().writeBinary(binaryOutputFile);
+}
+
 void ControlUnit::checkIndependentSet(const string &misInputFile) const {
     /* Build mis from input file */
     vector<uint32_t> mis;
@@ -61,7 +106,27 @@ void ControlUnit::checkIndependentSet(const string &misInputFile) const {
         }
     }
 
+    /* In a compacted or reordered graph, ids that do not occur in the input have no edges to conflict with */
+    const vector<uint32_t> &inputIds = Mis::getInputIds();
+    if (!inputIds.empty()) {
+        unordered_map<uint32_t, uint32_t> graphIds;
+        for (uint32_t node = 0 ; node < inputIds.size() ; node++) {
+            graphIds[inputIds[node]] = node;
+        }
+        vector<uint32_t> graphMis;
+        for (auto node: mis) {
+            auto graphId = graphIds.find(node);
+            if (graphId != graphIds.end()) {
+                graphMis.push_back(graphId->second);
+            }
+        }
+        mis.swap(graphMis);
+    }
     bool independentSet = alg.getSearchTree()[0]->getGraph().isIndependentSet(mis, &node1, &node2);
+    if (!independentSet && !inputIds.empty()) {
+        node1 = inputIds[node1];
+        node2 = inputIds[node2];
+    }
     if (independentSet) {
         cout << "Valid independent set\n";
     } else {
@@ -6,8 +6,9 @@
 
 class ControlUnit {
 public:
-    ControlUnit(const std::string &inputFile, const bool &checkIndependentSet) : alg(inputFile, checkIndependentSet) {}
+    ControlUnit(const std::string &inputFile, const Options &options) : alg(inputFile, options) {}
     void run();
+    void convert(const std::string &binaryOutputFile) const;
     void checkIndependentSet(const std::string &misInputFile) const;
 
 private:
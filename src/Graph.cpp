@@ -5,42 +5,125 @@
 #include <algorithm>
 #include <set>
 #include <stack>
+#include <queue>
+#include <atomic>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "Graph.hpp"
 
 using namespace std;
 
-Graph::Graph(const Graph &graph) {
-    nodeIndex = graph.nodeIndex;
-    zeroDegreeNodes = graph.zeroDegreeNodes;
-    nextUnusedId = graph.nextUnusedId;
-    mapping = graph.mapping;
-    edgeBuffer = new vector<uint32_t>(*(graph.edgeBuffer));
-    if (graph.mapping) {
-        idToPos = new unordered_map<uint32_t, uint32_t>(*(graph.idToPos));
-        posToId = new vector<uint32_t>(*(graph.posToId));
-    }
-}
+bool Graph::localityOrder = false;
+
+/* Copies share the edge buffer and the id mappers with the original graph, and only get
+ * their own at their first modification (see detachEdgeBuffer and detachMappers).
+ * Only nodeIndex is copied, so creating a copy does not depend on the number of edges */
+Graph::Graph(const Graph &graph) : nodeIndex(graph.nodeIndex), degreeBuckets(graph.degreeBuckets), edgeBuffer(graph.edgeBuffer), zeroDegreeNodes(graph.zeroDegreeNodes),
+    nextUnusedId(graph.nextUnusedId), mapping(graph.mapping), idToPos(graph.idToPos), posToId(graph.posToId), trailEnabled(false), touchedNodes(NULL) {}
 
 Graph& Graph::operator=(const Graph &graph) {
     if (this != &graph) {
         nodeIndex = graph.nodeIndex;
+        degreeBuckets = graph.degreeBuckets;
         zeroDegreeNodes = graph.zeroDegreeNodes;
         nextUnusedId = graph.nextUnusedId;
         mapping = graph.mapping;
-        edgeBuffer = new vector<uint32_t>(*(graph.edgeBuffer));
-        if (graph.mapping) {
-            idToPos = new unordered_map<uint32_t, uint32_t>(*(graph.idToPos));
-            posToId = new vector<uint32_t>(*(graph.posToId));
-        }
+        edgeBuffer = graph.edgeBuffer;
+        idToPos = graph.idToPos;
+        posToId = graph.posToId;
     }
     return *this;
 }
 
-Graph::~Graph() {
-    delete edgeBuffer;
-    if (mapping) {
-        delete idToPos;
-        delete posToId;
+/* Get a private copy of the edge buffer before modifying it, if it is shared with other graphs.
+ * Graphs of the parallel engine may release their reference from other threads, and the fence makes
+ * their last reads of the buffer happen before it is modified here */
+void Graph::detachEdgeBuffer() {
+    if (edgeBuffer.use_count() > 1) {
+        edgeBuffer = make_shared<vector<uint32_t> >(*edgeBuffer);
+    } else {
+        atomic_thread_fence(memory_order_acquire);
+    }
+}
+
+void Graph::detachMappers() {
+    if (!mapping) {
+        return;
+    }
+    if (idToPos.use_count() > 1) {
+        idToPos = make_shared<vector<uint32_t> >(*idToPos);
+    }
+    if (posToId.use_count() > 1) {
+        posToId = make_shared<vector<uint32_t> >(*posToId);
+    }
+    atomic_thread_fence(memory_order_acquire);
+}
+
+/* Keep the whole state before a rebuild. Structures that are replaced rather than modified
+ * by rebuild are only referenced, not copied */
+void Graph::recordSnapshot() {
+    snapshots.push_back(Snapshot());
+    Snapshot &snapshot = snapshots.back();
+    snapshot.nodeIndex = nodeIndex;
+    snapshot.edgeBuffer = edgeBuffer;
+    snapshot.zeroDegreeNodes = zeroDegreeNodes;
+    snapshot.mapping = mapping;
+    snapshot.idToPos = idToPos;
+    snapshot.posToId = posToId;
+    trail.push_back(TrailEntry(TrailEntry::Type::SNAPSHOT, snapshots.size() - 1, 0));
+}
+
+/* Revert modifications in reverse order, until the trail is back at mark */
+void Graph::undo(const size_t &mark) {
+    assert(mark <= trail.size());
+    while (trail.size() > mark) {
+        TrailEntry &entry = trail.back();
+        switch (entry.type) {
+            case TrailEntry::Type::NODE_INFO:
+                setNodeInfo(entry.pos, entry.nodeInfo);
+                break;
+            case TrailEntry::Type::EDGE:
+                (*edgeBuffer)[entry.pos] = entry.value;
+                break;
+            case TrailEntry::Type::EDGE_INSERTION:
+                /* pos is the previous edgeBuffer size, and the moved slot is restored by its NODE_INFO entry */
+                edgeBuffer->resize(entry.pos);
+                break;
+            case TrailEntry::Type::ZERO_DEGREE_NODE:
+                zeroDegreeNodes.pop_back();
+                break;
+            case TrailEntry::Type::NEW_NODE:
+                /* pos is the previous edgeBuffer size, nodeInfo.edges is set if the node was added to nodeIndex */
+                if (entry.nodeInfo.edges) {
+                    popNodeInfo();
+                    edgeBuffer->resize(entry.pos);
+                    if (mapping) {
+                        (*idToPos)[entry.value] = NONE;
+                        posToId->pop_back();
+                    }
+                }
+                nextUnusedId = entry.value;
+                break;
+            case TrailEntry::Type::SNAPSHOT: {
+                assert(entry.pos == snapshots.size() - 1);
+                Snapshot &snapshot = snapshots.back();
+                nodeIndex.swap(snapshot.nodeIndex);
+                edgeBuffer = snapshot.edgeBuffer;
+                zeroDegreeNodes.swap(snapshot.zeroDegreeNodes);
+                mapping = snapshot.mapping;
+                idToPos = snapshot.idToPos;
+                posToId = snapshot.posToId;
+                snapshots.pop_back();
+                buildDegreeBuckets();
+                break;
+            }
+            default:
+                assert(false);
+        }
+        trail.pop_back();
     }
 }
 
@@ -54,53 +137,51 @@ Graph::GraphTraversal::GraphTraversal(const Graph &graph, const uint32_t &node)
     graph.goToNode(node, *this);
 }
 
-/* Could be potentially replaced by structures that are updated on the fly as degrees change,
- * but is pretty fast and memory efficient nonetheless, even on huge graphs */
-void Graph::getMaxNodeDegree(uint32_t &node, uint32_t &maxDegree, const uint32_t &bound) const {
-    node = NONE;
-    maxDegree = 0;
-    for (uint32_t i = 0 ; i < nodeIndex.size() ; i++) {
-        if (!nodeIndex[i].removed && nodeIndex[i].edges > maxDegree) {
-            node = (!mapping ? i : posToId->at(i));
-            maxDegree = nodeIndex[i].edges;
-            if (bound != NONE && maxDegree >= bound) {
-                return;
-            }
+/* Put every node that is not removed in the bucket of its degree, after nodeIndex is replaced as a whole */
+void Graph::buildDegreeBuckets() {
+    degreeBuckets = DegreeBuckets();
+    degreeBuckets.next.assign(nodeIndex.size(), NONE);
+    degreeBuckets.previous.assign(nodeIndex.size(), NONE);
+    for (uint32_t pos = nodeIndex.size() ; pos-- > 0 ; ) {
+        if (!nodeIndex[pos].removed) {
+            insertIntoBucket(pos);
         }
     }
 }
 
-/* Optimized for short funnel detection to not necesssarily return the min degree,
- * if it is less than 3 */
-void Graph::getMinDegree(uint32_t &minDegree) const {
-    minDegree = NONE;
-    for (uint32_t i = 0 ; i < nodeIndex.size() ; i++) {
-        if (!nodeIndex[i].removed && nodeIndex[i].edges && nodeIndex[i].edges < minDegree) {
-            minDegree = nodeIndex[i].edges;
-            if (minDegree < 3) {
-                return;
-            }
+/* The node of maximum degree with the smallest position, found among the nodes of the top bucket only */
+void Graph::getMaxNodeDegree(uint32_t &node, uint32_t &maxDegree) const {
+    node = NONE;
+    maxDegree = degreeBuckets.maxDegree;
+    if (!maxDegree) {
+        return;
+    }
+    uint32_t minPos = NONE;
+    for (uint32_t pos = degreeBuckets.head[maxDegree] ; pos != NONE ; pos = degreeBuckets.next[pos]) {
+        if (pos < minPos) {
+            minPos = pos;
         }
     }
+    node = getNode(minPos);
 }
 
-uint32_t Graph::getTotalEdges() const {
-    uint32_t count = 0;
-    for (uint32_t pos = 0 ; pos < nodeIndex.size() ; pos++) {
-        if (!nodeIndex[pos].removed) {
-            count += nodeIndex[pos].edges;
+void Graph::getMinDegree(uint32_t &minDegree) const {
+    minDegree = NONE;
+    for (uint32_t degree = 1 ; degree <= degreeBuckets.maxDegree ; degree++) {
+        if (degreeBuckets.size[degree]) {
+            minDegree = degree;
+            return;
         }
     }
-    return count;
 }
 
 uint32_t Graph::getNumberOfDegreeNeighbors(const uint32_t &node, const uint32_t &degree, const uint32_t &atLeast) const {
     uint32_t count = 0;
-    uint32_t pos = (!mapping ? node : idToPos->at(node));
+    uint32_t pos = (!mapping ? node : (*idToPos)[node]);
     uint32_t neighborCount = nodeIndex[pos].edges;
-    uint32_t nextNodeOffset = (pos == nodeIndex.size()-1 ? edgeBuffer->size() : nodeIndex[pos+1].offset);
+    uint32_t nextNodeOffset = getSlotEnd(pos);
     for (uint32_t i = nodeIndex[pos].offset ; i < nextNodeOffset && neighborCount ; i++) {
-        uint32_t nPos = (!mapping ? (*edgeBuffer)[i] : idToPos->at((*edgeBuffer)[i]));
+        uint32_t nPos = (!mapping ? (*edgeBuffer)[i] : (*idToPos)[(*edgeBuffer)[i]]);
         if (!nodeIndex[nPos].removed) {
             neighborCount--;
             if (nodeIndex[nPos].edges == degree) {
@@ -121,18 +202,18 @@ void Graph::getNeighborsAtDistance2(const uint32_t &node, unordered_set<uint32_t
     if (degree != NONE && count != NULL) {
         *count = 0;
     }
-    uint32_t pos = (!mapping ? node : idToPos->at(node));
+    uint32_t pos = (!mapping ? node : (*idToPos)[node]);
     uint32_t neighborCount = nodeIndex[pos].edges;
-    uint32_t nextNodeOffset = (pos == nodeIndex.size()-1 ? edgeBuffer->size() : nodeIndex[pos+1].offset);
+    uint32_t nextNodeOffset = getSlotEnd(pos);
     for (uint32_t i = nodeIndex[pos].offset ; i < nextNodeOffset && neighborCount ; i++) {
-        uint32_t nPos = (!mapping ? (*edgeBuffer)[i] : idToPos->at((*edgeBuffer)[i]));
+        uint32_t nPos = (!mapping ? (*edgeBuffer)[i] : (*idToPos)[(*edgeBuffer)[i]]);
         if (!nodeIndex[nPos].removed) {
             neighborCount--;
             uint32_t neighborCount2 = nodeIndex[nPos].edges;
-            uint32_t nextNodeOffset2 = (nPos == nodeIndex.size()-1 ? edgeBuffer->size() : nodeIndex[nPos+1].offset);
+            uint32_t nextNodeOffset2 = getSlotEnd(nPos);
             for (uint32_t j = nodeIndex[nPos].offset ; j < nextNodeOffset2 && neighborCount2 ; j++) {
                 uint32_t id = (*edgeBuffer)[j];
-                uint32_t nPos2 = (!mapping ? id : idToPos->at(id));
+                uint32_t nPos2 = (!mapping ? id : (*idToPos)[id]);
                 if (!nodeIndex[nPos2].removed) {
                     neighborCount2--;
                     if (id != node && !edgeExists(id, node)) {
@@ -158,21 +239,45 @@ void Graph::rebuild(ReduceInfo &reduceInfo) {
     if (!reduceInfo.nodesRemoved) {
         return;
     }
+    if (trailEnabled) {
+        /* Compacting requires keeping the old structures in the trail. Only do it when the graph
+         * has at least halved since the last compaction, so that snapshots along a search path
+         * sum up to at most twice the original graph. Otherwise, just collect zero degree nodes */
+        uint32_t remainingNodes = 0;
+        for (uint32_t pos = 0 ; pos < this->nodeIndex.size() ; pos++) {
+            if (!this->nodeIndex[pos].removed && this->nodeIndex[pos].edges) {
+                remainingNodes++;
+            }
+        }
+        if (2 * remainingNodes > this->nodeIndex.size()) {
+            collectZeroDegreeNodes();
+            reduceInfo.nodesRemoved = 0;
+            return;
+        }
+        recordSnapshot();
+    }
     vector<NodeInfo> nodeIndex;
     uint32_t newNodes = (this->nodeIndex.size() > reduceInfo.nodesRemoved ? this->nodeIndex.size() - reduceInfo.nodesRemoved : this->nodeIndex.size());
     uint32_t newEdges = this->getTotalEdges();
     nodeIndex.reserve(newNodes);
-    vector<uint32_t> *edgeBuffer = new vector<uint32_t>();
+    shared_ptr<vector<uint32_t> > edgeBuffer = make_shared<vector<uint32_t> >();
     edgeBuffer->reserve(newEdges);
-    unordered_map<uint32_t, uint32_t> *idToPos = new unordered_map<uint32_t, uint32_t>();
-    vector<uint32_t> *posToId = new vector<uint32_t>();
+    shared_ptr<vector<uint32_t> > idToPos = make_shared<vector<uint32_t> >(nextUnusedId, NONE);
+    shared_ptr<vector<uint32_t> > posToId = make_shared<vector<uint32_t> >();
     posToId->reserve(newNodes);
     uint32_t offset = 0;
 
+    vector<uint32_t> order;
+    order.reserve(newNodes);
     for (uint32_t pos = 0 ; pos < this->nodeIndex.size() ; pos++) {
-        if (this->nodeIndex[pos].removed) {
-            continue;
+        if (!this->nodeIndex[pos].removed) {
+            order.push_back(pos);
         }
+    }
+    if (localityOrder) {
+        getBreadthFirstOrder(order);
+    }
+    for (auto pos: order) {
         uint32_t node = (!mapping ? pos : (*this->posToId)[pos]);
         if (!this->nodeIndex[pos].edges) {
             //cout << "Found node " << node << " with no edges at rebuilding\n";
@@ -180,10 +285,10 @@ void Graph::rebuild(ReduceInfo &reduceInfo) {
             continue;
         }
         uint32_t edges = 0;
-        uint32_t nextNodeOffset = (pos == this->nodeIndex.size()-1 ? this->edgeBuffer->size() : this->nodeIndex[pos+1].offset);
+        uint32_t nextNodeOffset = this->getSlotEnd(pos);
         /* Don't add neighbors that are marked as removed */
         for (uint32_t i = this->nodeIndex[pos].offset ; i < nextNodeOffset ; i++) {
-            uint32_t nPos = (!this->mapping ? (*this->edgeBuffer)[i] : this->idToPos->at((*this->edgeBuffer)[i]));
+            uint32_t nPos = (!this->mapping ? (*this->edgeBuffer)[i] : (*this->idToPos)[(*this->edgeBuffer)[i]]);
             if (!this->nodeIndex[nPos].removed) {
                 edgeBuffer->push_back((*this->edgeBuffer)[i]);
                 edges++;
@@ -193,52 +298,60 @@ void Graph::rebuild(ReduceInfo &reduceInfo) {
             }
         }
         assert(edges > 0);
-        idToPos->insert({node, nodeIndex.size()});
+        (*idToPos)[node] = nodeIndex.size();
         posToId->push_back(node);
         nodeIndex.push_back(Graph::NodeInfo(offset, edges));
         offset += edges;
     }
     this->mapping = true;
-    if (this->idToPos != NULL) {
-        delete this->idToPos;
-    }
-    if (this->posToId != NULL) {
-        delete this->posToId;
-    }
     this->idToPos = idToPos;
     this->posToId = posToId;
     this->nodeIndex = nodeIndex;
-    delete this->edgeBuffer;
     this->edgeBuffer = edgeBuffer;
+    buildDegreeBuckets();
     reduceInfo.nodesRemoved = 0;
 }
 
 void Graph::rebuildFromNodes(unordered_set<uint32_t> &nodes) {
+    if (trailEnabled) {
+        recordSnapshot();
+    }
     zeroDegreeNodes.clear();
     if (!nodes.size()) {
         nodeIndex.clear();
-        edgeBuffer->clear();
+        buildDegreeBuckets();
+        edgeBuffer = make_shared<vector<uint32_t> >();
         if (mapping) {
-            idToPos->clear();
-            posToId->clear();
+            idToPos = make_shared<vector<uint32_t> >(nextUnusedId, NONE);
+            posToId = make_shared<vector<uint32_t> >();
         }
         return;
     }
     vector<NodeInfo> nodeIndex;
     nodeIndex.reserve(nodes.size());
-    vector<uint32_t> *edgeBuffer = new vector<uint32_t>();
-    unordered_map<uint32_t, uint32_t> *idToPos = new unordered_map<uint32_t, uint32_t>();
-    vector<uint32_t> *posToId = new vector<uint32_t>();
+    shared_ptr<vector<uint32_t> > edgeBuffer = make_shared<vector<uint32_t> >();
+    shared_ptr<vector<uint32_t> > idToPos = make_shared<vector<uint32_t> >(nextUnusedId, NONE);
+    shared_ptr<vector<uint32_t> > posToId = make_shared<vector<uint32_t> >();
     posToId->reserve(nodes.size());
     uint32_t offset = 0;
 
-    for (auto node: nodes) {
+    vector<uint32_t> order;
+    if (localityOrder) {
+        for (auto node: nodes) {
+            order.push_back(getPos(node));
+        }
+        sort(order.begin(), order.end());
+        getBreadthFirstOrder(order, &nodes);
+    }
+    auto nextNode = nodes.begin();
+    for (uint32_t i = 0 ; i < nodes.size() ; i++) {
+        uint32_t node = (localityOrder ? getNode(order[i]) : *nextNode++);
         uint32_t edges = 0;
-        uint32_t pos = (!mapping ? node : this->idToPos->at(node));
-        uint32_t nextNodeOffset = (pos == this->nodeIndex.size()-1 ? this->edgeBuffer->size() : this->nodeIndex[pos+1].offset);
+        uint32_t pos = (!mapping ? node : (*this->idToPos)[node]);
+        uint32_t nextNodeOffset = this->getSlotEnd(pos);
         /* Don't add neighbors that are marked as removed or are outside of nodes struct */
         for (uint32_t i = this->nodeIndex[pos].offset ; i < nextNodeOffset ; i++) {
-            uint32_t nPos = (!this->mapping ? (*this->edgeBuffer)[i] : this->idToPos->at((*this->edgeBuffer)[i]));
+            uint32_t nPos = (!this->mapping ? (*this->edgeBuffer)[i] : (*this->idToPos)[(*this->edgeBuffer)[i]]);
             if (!this->nodeIndex[nPos].removed || nodes.find((*this->edgeBuffer)[i]) != nodes.end()) {
                 edgeBuffer->push_back((*this->edgeBuffer)[i]);
                 edges++;
@@ -250,24 +363,85 @@ void Graph::rebuildFromNodes(unordered_set<uint32_t> &nodes) {
         if (!edges) {
             zeroDegreeNodes.push_back(node);
         } else {
-            idToPos->insert({node, nodeIndex.size()});
+            (*idToPos)[node] = nodeIndex.size();
             posToId->push_back(node);
             nodeIndex.push_back(Graph::NodeInfo(offset, edges));
             offset += edges;
         }
     }
     this->mapping = true;
-    if (this->idToPos != NULL) {
-        delete this->idToPos;
-    }
-    if (this->posToId != NULL) {
-        delete this->posToId;
-    }
     this->idToPos = idToPos;
     this->posToId = posToId;
     this->nodeIndex = nodeIndex;
-    delete this->edgeBuffer;
     this->edgeBuffer = edgeBuffer;
+    buildDegreeBuckets();
+}
+
+/* Reorder positions breadth first, from each of them in turn that is not reached yet, so that neighbors are mostly
+ * laid out close to each other. Edges are followed as in rebuild, or within nodes when given, as in rebuildFromNodes */
+void Graph::getBreadthFirstOrder(vector<uint32_t> &positions, const unordered_set<uint32_t> *nodes) const {
+    vector<bool> visited(nodeIndex.size(), false);
+    vector<uint32_t> order;
+    order.reserve(positions.size());
+    for (auto root: positions) {
+        if (visited[root]) {
+            continue;
+        }
+        visited[root] = true;
+        order.push_back(root);
+        for (uint32_t next = order.size() - 1 ; next < order.size() ; next++) {
+            uint32_t pos = order[next];
+            uint32_t edges = 0;
+            uint32_t nextNodeOffset = getSlotEnd(pos);
+            for (uint32_t i = nodeIndex[pos].offset ; i < nextNodeOffset && edges < nodeIndex[pos].edges ; i++) {
+                uint32_t neighbor = (*edgeBuffer)[i];
+                uint32_t nPos = getPos(neighbor);
+                bool inNodes = (nodes == NULL ? !nodeIndex[nPos].removed : nodes->find(neighbor) != nodes->end());
+                if (!nodeIndex[nPos].removed || inNodes) {
+                    edges++;
+                }
+                if (inNodes && !visited[nPos]) {
+                    visited[nPos] = true;
+                    order.push_back(nPos);
+                }
+            }
+        }
+    }
+    positions.swap(order);
+}
+
+/* Renumber the ids of a graph just loaded in breadth first order, which rebuild keeps afterwards. The input id of each
+ * new id is appended to inputIds, through the old inputIds if there are any */
+void Graph::relabel(vector<uint32_t> &inputIds) {
+    vector<uint32_t> order(nodeIndex.size());
+    for (uint32_t node = 0 ; node < nodeIndex.size() ; node++) {
+        order[node] = node;
+    }
+    getBreadthFirstOrder(order);
+    vector<uint32_t> newId(nodeIndex.size());
+    for (uint32_t node = 0 ; node < order.size() ; node++) {
+        newId[order[node]] = node;
+    }
+    vector<NodeInfo> nodeIndex;
+    nodeIndex.reserve(order.size());
+    shared_ptr<vector<uint32_t> > edgeBuffer = make_shared<vector<uint32_t> >();
+    edgeBuffer->reserve(this->edgeBuffer->size());
+    for (auto node: order) {
+        auto begin = this->edgeBuffer->begin() + this->nodeIndex[node].offset;
+        nodeIndex.push_back(NodeInfo(edgeBuffer->size(), this->nodeIndex[node].edges));
+        for (auto edge = begin ; edge != begin + this->nodeIndex[node].edges ; edge++) {
+            edgeBuffer->push_back(newId[*edge]);
+        }
+        sort(edgeBuffer->end() - this->nodeIndex[node].edges, edgeBuffer->end());
+    }
+    this->nodeIndex.swap(nodeIndex);
+    this->edgeBuffer = edgeBuffer;
+    if (!inputIds.empty()) {
+        for (auto &node: order) {
+            node = inputIds[node];
+        }
+    }
+    inputIds.swap(order);
 }
 
 /* Contract 'nodes' and 'neighbors' to a single node.
@@ -275,7 +449,9 @@ void Graph::rebuildFromNodes(unordered_set<uint32_t> &nodes) {
 uint32_t Graph::contractToSingleNode(const vector<uint32_t> &nodes, const vector<uint32_t> &neighbors, ReduceInfo &reduceInfo) {
     uint32_t newNode = nextUnusedId;
     assert(++nextUnusedId != 0);
-    assert(!mapping || mapping && idToPos->find(newNode) == idToPos->end());
+    assert(!mapping || mapping && (newNode >= idToPos->size() || (*idToPos)[newNode] == NONE));
+    detachEdgeBuffer();
+    detachMappers();
     set<uint32_t> newNeighbors;
     for (auto it = neighbors.begin() ; it != neighbors.end() ; it++) {
         GraphTraversal graphTraversal(*this, *it);
@@ -284,23 +460,37 @@ uint32_t Graph::contractToSingleNode(const vector<uint32_t> &nodes, const vector
             if (find(nodes.begin(), nodes.end(), neighbor) == nodes.end() && find(neighbors.begin(), neighbors.end(), neighbor) == neighbors.end()) {
                 if (newNeighbors.insert(neighbor).second) {
                     replaceNeighbor(neighbor, *it, newNode);
-                    uint32_t pos = (!mapping ? neighbor : idToPos->at(neighbor));
-                    nodeIndex[pos].edges++;
+                    uint32_t pos = (!mapping ? neighbor : (*idToPos)[neighbor]);
+                    recordNodeInfo(pos);
+                    setEdges(pos, nodeIndex[pos].edges + 1);
                 }
             }
             getNextEdge(graphTraversal);
         }
     }
     reduceInfo.nodesRemoved--;
+    /* Without a mapping, ids are positions, so a new node takes a position even if it has no neighbors */
+    bool newPos = newNeighbors.size() || !mapping;
+    if (trailEnabled) {
+        trail.push_back(TrailEntry(TrailEntry::Type::NEW_NODE, edgeBuffer->size(), newNode, NodeInfo(0, newPos)));
+    }
     if (!newNeighbors.size()) {
-        zeroDegreeNodes.push_back(newNode);
+        pushZeroDegreeNode(newNode);
+        if (newPos) {
+            NodeInfo nodeInfo(edgeBuffer->size(), 0);
+            nodeInfo.removed = true;
+            pushNodeInfo(nodeInfo);
+        }
     } else {
         uint32_t offset = edgeBuffer->size();
         edgeBuffer->reserve(edgeBuffer->size() + newNeighbors.size());
         copy(newNeighbors.begin(), newNeighbors.end(), back_inserter(*edgeBuffer));
-        nodeIndex.push_back(NodeInfo(offset, newNeighbors.size()));
+        pushNodeInfo(NodeInfo(offset, newNeighbors.size()));
         if (mapping) {
-            idToPos->insert({newNode, nodeIndex.size() - 1});
+            if (newNode >= idToPos->size()) {
+                idToPos->resize(newNode + 1, NONE);
+            }
+            (*idToPos)[newNode] = nodeIndex.size() - 1;
             posToId->push_back(newNode);
         }
     }
@@ -311,48 +501,18 @@ void Graph::replaceNeighbor(const uint32_t &node, const uint32_t &oldNeighbor, c
     uint32_t offset;
     offset = findEdgeOffset(node, oldNeighbor);
     assert(offset != NONE);
-    uint32_t pos = (!mapping ? node : idToPos->at(node));
-    uint32_t endOffset = (pos == nodeIndex.size()-1 ? edgeBuffer->size() : nodeIndex[pos+1].offset);
+    detachEdgeBuffer();
+    uint32_t pos = (!mapping ? node : (*idToPos)[node]);
+    touch(pos);
+    uint32_t endOffset = getSlotEnd(pos);
+    for (uint32_t i = offset ; i < endOffset ; i++) {
+        recordEdge(i);
+    }
     auto it = edgeBuffer->begin();
     move(it + offset + 1, it + endOffset, it + offset);
     (*edgeBuffer)[endOffset-1] = newNeighbor;
 }
 
-uint32_t Graph::getNextNodeWithIdenticalNeighbors(const uint32_t &previousNode, const vector<uint32_t> &neighbors) const {
-    uint32_t pos = (!mapping ? previousNode : idToPos->at(previousNode));
-    for (pos = pos+1 ; pos < nodeIndex.size() ; pos++) {
-        if (!nodeIndex[pos].removed && nodeIndex[pos].edges == neighbors.size()) {
-            uint32_t neighborCount = neighbors.size();
-            uint32_t nextNodeOffset = (pos == nodeIndex.size()-1 ? edgeBuffer->size() : nodeIndex[pos+1].offset);
-            for (uint32_t offset = nodeIndex[pos].offset ; offset  < nextNodeOffset && neighborCount; offset++) {
-                uint32_t nPos = (!mapping ? (*edgeBuffer)[offset] : idToPos->at((*edgeBuffer)[offset]));
-                if (!nodeIndex[nPos].removed && find(neighbors.begin(), neighbors.end(), (*edgeBuffer)[offset]) != neighbors.end()) {
-                    neighborCount--;
-                }
-            }
-            if (!neighborCount) {
-                return (!mapping ? pos : posToId->at(pos));
-            }
-        }
-    }
-    return NONE;
-}
-
-uint32_t Graph::getNodeWithOneUncommonNeighbor(const vector<uint32_t> &neighbors, uint32_t &uncommonNeighbor) const {
-    uncommonNeighbor = NONE;
-    for (uint32_t pos = 0 ; pos < nodeIndex.size() ; pos++) {
-        if (!nodeIndex[pos].removed && nodeIndex[pos].edges == 3 || nodeIndex[pos].edges == 4) { // Optimization for 3-4 structures reduction
-            uint32_t node = (!mapping ? pos : posToId->at(pos));
-            vector<uint32_t> newNeighbors;
-            gatherNeighbors(node, newNeighbors);
-            if (setsHaveKUncommonElements(neighbors, newNeighbors, 1, uncommonNeighbor)) {
-                return node;
-            }
-        }
-    }
-    return NONE;
-}
-
 void Graph::getExtendedGrandchildren(Graph::GraphTraversal &graphTraversal, unordered_set<uint32_t> &extendedGrandchildren, bool *isUnconfined, const bool &stopAtFirst) const {
     while (graphTraversal.curEdgeOffset != NONE) {
         uint32_t neighbor = (*edgeBuffer)[graphTraversal.curEdgeOffset];
@@ -709,6 +869,7 @@ bool Graph::getEffectiveNodeOrOptimalFunnel(uint32_t &effectiveNode, uint32_t &n
             }
         }
     }
+    return false;
 }
 
 bool Graph::getGoodFunnel(uint32_t &node1, uint32_t &node2) const {
@@ -1086,9 +1247,9 @@ void Graph::getOptimalShortEdge(const uint32_t &degree, uint32_t &finalNode1, ui
         }
         if (nodeIndex[pos].edges == degree) {
             uint32_t neighborCount = degree;
-            uint32_t nextNodeOffset = (pos == nodeIndex.size()-1 ? edgeBuffer->size() : nodeIndex[pos+1].offset);
+            uint32_t nextNodeOffset = getSlotEnd(pos);
             for (uint32_t offset = nodeIndex[pos].offset ; offset < nextNodeOffset && neighborCount; offset++) {
-                uint32_t nPos = (!mapping ? (*edgeBuffer)[offset] : idToPos->at((*edgeBuffer)[offset]));
+                uint32_t nPos = (!mapping ? (*edgeBuffer)[offset] : (*idToPos)[(*edgeBuffer)[offset]]);
                 if (nodeIndex[nPos].removed) {
                     continue;
                 }
@@ -1118,8 +1279,8 @@ void Graph::getOptimalShortEdge(const uint32_t &degree, uint32_t &finalNode1, ui
 }
 
 void Graph::getCommonNeighbors(const uint32_t &node1, const uint32_t &node2, vector<uint32_t> &commonNeighbors, const uint32_t &atLeast) const {
-    uint32_t pos1 = (!mapping ? node1 : idToPos->at(node1));
-    uint32_t pos2 = (!mapping ? node2 : idToPos->at(node2));
+    uint32_t pos1 = (!mapping ? node1 : (*idToPos)[node1]);
+    uint32_t pos2 = (!mapping ? node2 : (*idToPos)[node2]);
     assert(!nodeIndex[pos1].removed && !nodeIndex[pos2].removed);
     uint32_t count = 0;
     vector<uint32_t> neighbors1;
@@ -1138,480 +1299,448 @@ void Graph::getCommonNeighbors(const uint32_t &node1, const uint32_t &node2, vec
  * the mirror edges are not added. It is more performant to add them manually with another call
  * to this function, along with any other edges. (Optimization for branching on edges) */
 void Graph::addEdges(const uint32_t node, const vector<uint32_t> &nodes) {
-    uint32_t pos = (!mapping ? node : idToPos->at(node));
+    uint32_t pos = (!mapping ? node : (*idToPos)[node]);
     set<uint32_t> neighbors;
     vector<uint32_t> removedNeighbors;
     gatherNeighborsWithRemoved(node, neighbors, removedNeighbors);
     uint32_t space = neighbors.size() + removedNeighbors.size();
     neighbors.insert(nodes.begin(), nodes.end());
     uint32_t finalNeighborCount = neighbors.size();
+    detachEdgeBuffer();
     if (neighbors.size() <= space) {
         while (neighbors.size() < space) {
             uint32_t removed = removedNeighbors.back();
             removedNeighbors.pop_back();
             neighbors.insert(removed);
         }
+        for (uint32_t offset = nodeIndex[pos].offset ; offset < nodeIndex[pos].offset + space ; offset++) {
+            recordEdge(offset);
+        }
         copy(neighbors.begin(), neighbors.end(), edgeBuffer->begin() + nodeIndex[pos].offset);
+        recordNodeInfo(pos);
+        setEdges(pos, finalNeighborCount);
     } else {
-        auto it = neighbors.begin();
-        uint32_t insertedElements = 0;
-        uint32_t nextNodeOffset = (pos == nodeIndex.size()-1 ? edgeBuffer->size() : nodeIndex[pos+1].offset);
-        for (uint32_t offset = nodeIndex[pos].offset ; offset < nextNodeOffset ; offset++) {
-            (*edgeBuffer)[offset] = *it;
-            it++;
-            insertedElements++;
-        }
-        uint32_t addition = (neighbors.size() - insertedElements);
-        edgeBuffer->reserve(edgeBuffer->size() + addition);
-        edgeBuffer->insert(edgeBuffer->begin() + nextNodeOffset, it, neighbors.end());
-        for (uint32_t i = pos + 1 ; i < nodeIndex.size() ; i++) {
-            nodeIndex[i].offset += addition;
+        /* Move the neighbors to a new slot at the end of edgeBuffer, leaving the old one unused until the next rebuild,
+         * instead of shifting the slots of all later positions */
+        if (trailEnabled) {
+            trail.push_back(TrailEntry(TrailEntry::Type::EDGE_INSERTION, edgeBuffer->size(), neighbors.size()));
         }
+        recordNodeInfo(pos);
+        NodeInfo nodeInfo(edgeBuffer->size(), finalNeighborCount);
+        nodeInfo.removed = nodeIndex[pos].removed;
+        edgeBuffer->insert(edgeBuffer->end(), neighbors.begin(), neighbors.end());
+        setNodeInfo(pos, nodeInfo);
     }
-    nodeIndex[pos].edges = finalNeighborCount;
 }
 
 void Graph::collectZeroDegreeNodes() {
     for (uint32_t pos = 0 ; pos < nodeIndex.size() ; pos++) {
         if (!nodeIndex[pos].removed && !nodeIndex[pos].edges) {
-            zeroDegreeNodes.push_back((!mapping ? pos : posToId->at(pos)));
-            nodeIndex[pos].removed = true;
+            pushZeroDegreeNode((!mapping ? pos : posToId->at(pos)));
+            recordNodeInfo(pos);
+            setRemoved(pos);
         }
     }
 }
 
-bool Graph::getArticulationPoints(unordered_set<uint32_t> &vertexCut, vector<uint32_t> &component1, vector<uint32_t> &component2, bool &actualComponent1, bool &connected) const {
-    struct Value {
-        Value(const uint32_t &visit) : visit(visit), low(visit) {}
-        uint32_t visit;
-        uint32_t low;
-    };
-
-    struct Instance {
-        Instance(const uint32_t &node, const uint32_t &parentNode, const Graph &graph) : graphTraversal(graph, node), parentNode(parentNode), dfsChildren(0) {}
-        GraphTraversal graphTraversal;
-        uint32_t parentNode;
-        uint32_t dfsChildren;
+/* Find the blocks of every component with edges, with a depth first search from the first node of each on arrays indexed
+ * by position. A node a with a child c closes a block when no frond from the subtree of c reaches above a, and the block is
+ * a and the nodes still on the stack from c on */
+void Graph::buildBlockCutTree(BlockCutTree &tree) const {
+    tree.preorder.clear();
+    tree.blockOffset.assign(1, 0);
+    tree.blockNodes.clear();
+    tree.blockTop.clear();
+    tree.blockDegreeSum.clear();
+    tree.subtreeBegin.clear();
+    tree.subtreeSize.clear();
+    tree.connected = true;
+
+    /* Preorder numbers start from 1, so that 0 means unvisited */
+    vector<uint32_t> num(nodeIndex.size(), 0);
+    vector<uint32_t> low(nodeIndex.size());
+    vector<uint32_t> nd(nodeIndex.size(), 1);
+    vector<uint32_t> parent(nodeIndex.size(), NONE);
+    vector<uint32_t> nextOffset(nodeIndex.size());
+    vector<uint32_t> path;
+    vector<uint32_t> blockStack;
+    auto discover = [&](const uint32_t &pos, const uint32_t &parentPos) {
+        tree.preorder.push_back(getNode(pos));
+        num[pos] = low[pos] = tree.preorder.size();
+        parent[pos] = parentPos;
+        nextOffset[pos] = nodeIndex[pos].offset;
+        path.push_back(pos);
+        blockStack.push_back(pos);
     };
+    for (uint32_t root = 0 ; root < nodeIndex.size() ; root++) {
+        if (nodeIndex[root].removed || !nodeIndex[root].edges || num[root]) {
+            continue;
+        }
+        if (!tree.preorder.empty()) {
+            tree.connected = false;
+        }
+        discover(root, NONE);
+        while (!path.empty()) {
+            uint32_t pos = path.back();
+            uint32_t nextNodeOffset = getSlotEnd(pos);
+            if (nextOffset[pos] < nextNodeOffset) {
+                uint32_t neighborPos = getPos((*edgeBuffer)[nextOffset[pos]++]);
+                if (nodeIndex[neighborPos].removed || neighborPos == pos) {
+                    continue;
+                }
+                if (!num[neighborPos]) {
+                    discover(neighborPos, pos);
+                } else if (num[neighborPos] < low[pos]) {
+                    low[pos] = num[neighborPos];
+                }
+                continue;
+            }
+            path.pop_back();
+            uint32_t parentPos = parent[pos];
+            if (parentPos == NONE) {
+                continue;
+            }
+            nd[parentPos] += nd[pos];
+            low[parentPos] = min(low[parentPos], low[pos]);
+            if (low[pos] >= num[parentPos]) {
+                uint32_t degreeSum = nodeIndex[parentPos].edges;
+                tree.blockNodes.push_back(getNode(parentPos));
+                uint32_t blockPos;
+                do {
+                    blockPos = blockStack.back();
+                    blockStack.pop_back();
+                    tree.blockNodes.push_back(getNode(blockPos));
+                    degreeSum += nodeIndex[blockPos].edges;
+                } while (blockPos != pos);
+                tree.blockOffset.push_back(tree.blockNodes.size());
+                tree.blockTop.push_back(getNode(parentPos));
+                tree.blockDegreeSum.push_back(degreeSum);
+                tree.subtreeBegin.push_back(num[pos] - 1);
+                tree.subtreeSize.push_back(nd[pos]);
+            }
+        }
+    }
+}
 
+/* Find the articulation point that leaves exactly two components, and splits the graph most evenly. Those are the
+ * nodes in exactly two blocks. The side of the block that hangs from it is a range of the preorder, and its degree sum
+ * for choosing the actual component as in checkSeparation comes from prefix sums, adjusted for the edges to the cut */
+bool Graph::getArticulationPoints(unordered_set<uint32_t> &vertexCut, vector<uint32_t> &component1, vector<uint32_t> &component2, bool &actualComponent1, bool &connected) const {
     vertexCut.clear();
     component1.clear();
     component2.clear();
-
-    Graph::GraphTraversal graphTraversal(*this);
-    if (graphTraversal.curNode == NONE) {
+    BlockCutTree tree;
+    buildBlockCutTree(tree);
+    connected = tree.connected;
+    if (!connected || tree.getBlocks() < 2) {
         return false;
     }
-    unordered_set<uint32_t> articulationPoints;
-    unordered_map<uint32_t, Value> exploredSet;
-    stack<Instance> frontier;
-    uint32_t visit = 0;
-    uint32_t root = NONE;
-    if (exploredSet.find(graphTraversal.curNode) == exploredSet.end()) {
-        root = graphTraversal.curNode;
-        frontier.push(Instance(graphTraversal.curNode, NONE, *this));
-        while (!frontier.empty()) {
-            uint32_t node = frontier.top().graphTraversal.curNode;
-            exploredSet.insert({node, Value(visit)});
-            visit++;
-            bool newCall;
-            do {
-                node = frontier.top().graphTraversal.curNode;
-                Graph::GraphTraversal &neighbors = frontier.top().graphTraversal;
-                newCall = false;
-                while (neighbors.curEdgeOffset != NONE) {
-                    uint32_t neighbor = (*edgeBuffer)[neighbors.curEdgeOffset];
-                    if (neighbor != node) {
-                        auto it = exploredSet.find(neighbor);
-                        if (it == exploredSet.end()) {
-                            newCall = true;
-                            frontier.top().dfsChildren++;
-                            frontier.push(Instance(neighbor, node, *this));
-                            break;
-                        } else if (it->second.visit < exploredSet.find(node)->second.visit) {
-                            auto it1 = exploredSet.find(node);
-                            if (it->second.visit < it1->second.low) {
-                                it1->second.low = it->second.visit;
-                            }
-                        }
-                    }
-                    getNextEdge(neighbors);
-                }
-                if (!newCall) {
-                    uint32_t parentNode = frontier.top().parentNode;
-                    if (frontier.size() > 1) {
-                        auto it1 = exploredSet.find(parentNode);
-                        auto it2 = exploredSet.find(node);
-                        assert(it1 != exploredSet.end() && it2 != exploredSet.end());
-                        if (it2->second.low < it1->second.low) {
-                            it1->second.low = it2->second.low;
-                        }
-                        if (parentNode != root && it2->second.low >= it1->second.visit && articulationPoints.insert(parentNode).second) {
-                            //cout << "Articulation point " << parentNode << "\n";
-                            unordered_set<uint32_t> cut;
-                            cut.insert(parentNode);
-                            if (checkSeparation(cut, component1, component2, actualComponent1)) {
-                                vertexCut = cut;
-                                //cout << "Articulation point " << parentNode << "\n";
-                                return true;
-                            }
-                        }
-                        frontier.pop();
-                        if (frontier.top().graphTraversal.curEdgeOffset != NONE) {
-                            getNextEdge(frontier.top().graphTraversal);
-                        }
-                    } else if (frontier.size() == 1) {
-                        if (frontier.top().dfsChildren > 1 && articulationPoints.insert(frontier.top().graphTraversal.curNode).second) {
-                            //cout << "Root articulation point " << frontier.top().graphTraversal.curNode << "\n";
-                            unordered_set<uint32_t> cut;
-                            cut.insert(frontier.top().graphTraversal.curNode);
-                            if (checkSeparation(cut, component1, component2, actualComponent1)) {
-                                vertexCut = cut;
-                                //cout << "Root articulation point " << frontier.top().graphTraversal.curNode << "\n";
-                                return true;
-                            }
-                        }
-                        frontier.pop();
-                        break;
-                    }
-                }
-            } while (!newCall);
+    vector<uint32_t> blocksOfNode(nodeIndex.size(), 0);
+    for (auto node: tree.blockNodes) {
+        blocksOfNode[getPos(node)]++;
+    }
+    /* Nodes of degree less than 3 do not count towards the degree sum */
+    auto getWeight = [](const uint32_t &degree) {
+        return (degree >= 3 ? degree : 0);
+    };
+    uint32_t nodes = tree.preorder.size();
+    vector<uint32_t> weightSum(nodes + 1, 0);
+    for (uint32_t i = 0 ; i < nodes ; i++) {
+        weightSum[i + 1] = weightSum[i] + getWeight(getNodeDegree(tree.preorder[i]));
+    }
+    uint32_t bestBlock = NONE;
+    uint32_t bestSize = 0;
+    for (uint32_t block = 0 ; block < tree.getBlocks() ; block++) {
+        uint32_t top = getPos(tree.blockTop[block]);
+        if (blocksOfNode[top] != 2) {
+            continue;
+        }
+        blocksOfNode[top]++; // The root is the top of both of its blocks, which give the same cut
+        uint32_t smallerSide = min(tree.subtreeSize[block], nodes - 1 - tree.subtreeSize[block]);
+        if (smallerSide > bestSize) {
+            bestBlock = block;
+            bestSize = smallerSide;
         }
     }
-    if (exploredSet.size() != getNodeCountWithEdges()) {
-        connected = false;
-    } else {
-        connected = true;
+    if (bestBlock == NONE) {
+        return false;
     }
-    return false;
-}
-
-void Graph::addPalmTreeArc(unordered_map<uint32_t, vector<uint32_t> > &palmTree, const uint32_t &node, const uint32_t &neighbor) {
-    auto res = palmTree.find(node);
-    if (res == palmTree.end()) {
-        vector<uint32_t> tmp;
-        tmp.push_back(neighbor);
-        palmTree.insert({node, tmp});
-    } else {
-        res->second.push_back(neighbor);
+    uint32_t cutNode = tree.blockTop[bestBlock];
+    uint32_t begin = tree.subtreeBegin[bestBlock];
+    uint32_t end = begin + tree.subtreeSize[bestBlock];
+    uint32_t degreeSum1 = weightSum[end] - weightSum[begin];
+    uint32_t degreeSum2 = weightSum[nodes] - degreeSum1 - getWeight(getNodeDegree(cutNode));
+    vector<uint32_t> neighbors;
+    gatherNeighbors(cutNode, neighbors);
+    vector<uint32_t> num(nodeIndex.size());
+    for (uint32_t i = 0 ; i < nodes ; i++) {
+        num[getPos(tree.preorder[i])] = i;
+    }
+    for (auto neighbor: neighbors) {
+        uint32_t degree = getNodeDegree(neighbor);
+        uint32_t &degreeSum = (num[getPos(neighbor)] >= begin && num[getPos(neighbor)] < end ? degreeSum1 : degreeSum2);
+        degreeSum = degreeSum - getWeight(degree) + getWeight(degree - 1);
+    }
+    vertexCut.insert(cutNode);
+    component1.assign(tree.preorder.begin() + begin, tree.preorder.begin() + end);
+    for (uint32_t i = 0 ; i < nodes ; i++) {
+        if ((i < begin || i >= end) && tree.preorder[i] != cutNode) {
+            component2.push_back(tree.preorder[i]);
+        }
     }
+    actualComponent1 = (degreeSum1 <= degreeSum2);
+    //cout << "Articulation point " << cutNode << "\n";
+    return true;
 }
 
-
-bool Graph::getSeparatingPairs(unordered_set<uint32_t> &vertexCut, vector<uint32_t> &component1, vector<uint32_t> &component2, bool &actualComponent1) const {
-    struct Instance {
-        Instance(const uint32_t &node, const uint32_t &parentNode, const Graph &graph) : graphTraversal(graph, node), parentNode(parentNode) {}
-        GraphTraversal graphTraversal;
-        uint32_t parentNode;
-    };
-
-    Graph::GraphTraversal graphTraversal(*this);
-    if (graphTraversal.curNode == NONE) {
-        return false;
-    }
-    vertexCut.clear();
-    component1.clear();
-    component2.clear();
-    unordered_map<uint32_t, uint32_t> visitToId;
-    unordered_map<uint32_t, Value1> exploredSet;
-    stack<Instance> frontier;
-    unordered_set<uint32_t> flags;
-    unordered_map<uint32_t, uint32_t> fathers;
-    unordered_map<uint32_t, uint32_t> sons;
-    unordered_map<uint32_t, vector<uint32_t> > palmTree1;
-    unordered_map<uint32_t, vector<uint32_t> > palmTree2;
-    unordered_map<uint32_t, vector<uint32_t> > bothPalmTrees;
-    unordered_map<uint32_t, unordered_set<uint32_t> > descendants;
-    uint32_t visit = 0;
-    uint32_t numberOfNodes = 0;
-    if (exploredSet.find(graphTraversal.curNode) == exploredSet.end()) {
-        frontier.push(Instance(graphTraversal.curNode, NONE, *this));
-        while (!frontier.empty()) {
-            uint32_t node = frontier.top().graphTraversal.curNode;
-            visit++;
-            exploredSet.insert({node, Value1(visit)});
-            visitToId.insert({visit, node});
-            sons.insert({visit, 0});
-            numberOfNodes++;
-            bool newCall;
-            do {
-                node = frontier.top().graphTraversal.curNode;
-                Graph::GraphTraversal &neighbors = frontier.top().graphTraversal;
-                newCall = false;
-                while (neighbors.curEdgeOffset != NONE) {
-                    uint32_t neighbor = (*edgeBuffer)[neighbors.curEdgeOffset];
-                    auto it = exploredSet.find(neighbor);
-                    if (it == exploredSet.end()) {
-                        addPalmTreeArc(palmTree1, node, neighbor);
-                        addPalmTreeArc(bothPalmTrees, node, neighbor);
-                        fathers.insert({neighbor, node});
-                        newCall = true;
-                        frontier.push(Instance(neighbor, node, *this));
-                        break;
-                    } else if (neighbor != node && it->second.visit < exploredSet.find(node)->second.visit || flags.find(node) != flags.end()) {
-                        addPalmTreeArc(palmTree2, node, neighbor);
-                        addPalmTreeArc(bothPalmTrees, node, neighbor);
-                        auto it1 = exploredSet.find(node);
-                        if (it->second.visit < it1->second.low1) {
-                            it1->second.low2 = it1->second.low1;
-                            it1->second.low1 = it->second.visit;
-                        } else if (it->second.visit > it1->second.low1) {
-                            if (it->second.visit < it1->second.low2) {
-                                it1->second.low2 = it->second.visit;
-                            }
-                        }
-                    } else if (neighbor == node && flags.find(node) == flags.end()) {
-                        flags.insert(node);
-                    }
-                    getNextEdge(neighbors);
-                }
-                if (!newCall) {
-                    uint32_t parentNode = frontier.top().parentNode;
-                    if (parentNode == NONE) {
-                        assert(frontier.size() == 1);
-                        frontier.pop();
-                        break;
-                    }
-                    auto it1 = exploredSet.find(parentNode);
-                    auto it2 = exploredSet.find(node);
-                    assert(it1 != exploredSet.end() && it2 != exploredSet.end());
-                    it1->second.nd += (1 + it2->second.nd);
-                    auto d1 = descendants.find(parentNode);
-                    if (d1 == descendants.end()) {
-                        descendants.insert({parentNode, unordered_set<uint32_t>()});
-                        d1 = descendants.find(parentNode);
-                    }
-                    d1->second.insert(node);
-                    auto d2 = descendants.find(node);
-                    if (d2 != descendants.end()) {
-                        d1->second.insert(d2->second.begin(), d2->second.end());
-                    }
-                    if (it2->second.low1 < it1->second.low1) {
-                        it1->second.low2 = it1->second.low1;
-                        if (it2->second.low2 < it1->second.low1) {
-                            it1->second.low2 = it2->second.low2;
-                        }
-                        it1->second.low1 = it2->second.low1;
-                    } else if (it2->second.low1 == it1->second.low1) {
-                        if (it2->second.low2 < it1->second.low2) {
-                            it1->second.low2 = it2->second.low2;
-                        }
-                    } else if (it2->second.low1 < it1->second.low2) {
-                        it1->second.low2 = it2->second.low1;
-                    }
-                    frontier.pop();
-                    if (!frontier.size()) {
-                        break;
-                    }
-                    if (frontier.top().graphTraversal.curEdgeOffset != NONE) {
-                        getNextEdge(frontier.top().graphTraversal);
-                    }
-                }
-            } while (!newCall);
+/* Find separation pairs of a connected graph with a single depth first search on arrays indexed by position, and return all
+ * of them as pairs of ids. With lowpoints as in Hopcroft and Tarjan, {a, b} with a an ancestor of b is found when:
+ * 1. A subtree of a child r of b only has fronds to a and b, i.e. lowpt2(r) >= b and lowpt1(r) = a.
+ * 2. The nodes between them, which are the subtree of the child r of a towards b without the subtree of b, only have fronds
+ *    to a and each other, and the subtree of b has no fronds to them. The second holds for every a from the highest frond
+ *    target above b of the subtree of b down, and only the highest and lowest such a are checked, to stay linear.
+ * Both also require nodes outside of the two sides. Pairs of the second kind between the two ends are missed, and each
+ * pair is checked with checkSeparation by the caller, so the graph does not need to be biconnected */
+void Graph::findSeparationPairs(vector<pair<uint32_t, uint32_t> > &pairs) const {
+    pairs.clear();
+    uint32_t root = NONE;
+    for (uint32_t pos = 0 ; pos < nodeIndex.size() ; pos++) {
+        if (!nodeIndex[pos].removed && nodeIndex[pos].edges) {
+            root = pos;
+            break;
         }
     }
-    if (getSeparatingPairs2(vertexCut, component1, component2, actualComponent1, numberOfNodes, palmTree1, palmTree2, bothPalmTrees, exploredSet, fathers, sons, descendants, visitToId)) {
-        return true;
+    if (root == NONE) {
+        return;
     }
-    return false;
-}
 
-    bool Graph::getSeparatingPairs2(unordered_set<uint32_t> &vertexCut, vector<uint32_t> &component1, vector<uint32_t> &component2, bool &actualComponent1,
-                               const uint32_t &numberOfNodes, unordered_map<uint32_t, vector<uint32_t> > &palmTree1, unordered_map<uint32_t, vector<uint32_t> > &palmTree2,
-                               unordered_map<uint32_t, vector<uint32_t> > &bothPalmTrees, unordered_map<uint32_t, Value1> &oldExploredSet, unordered_map<uint32_t, uint32_t> &fathers,
-                               unordered_map<uint32_t, uint32_t> &sons, unordered_map<uint32_t, unordered_set<uint32_t> > &descendants, unordered_map<uint32_t, uint32_t> &visitToId) const {
+    /* Depth first search, numbering nodes from 1 in preorder. Lowpoints are the two smallest distinct numbers among a node
+     * and the frond targets of its subtree, and own is the smallest frond target of the node itself */
+    vector<uint32_t> num(nodeIndex.size(), 0);
+    vector<uint32_t> parent(nodeIndex.size(), NONE);
+    vector<uint32_t> low1(nodeIndex.size());
+    vector<uint32_t> low2(nodeIndex.size());
+    vector<uint32_t> nd(nodeIndex.size(), 1);
+    vector<uint32_t> own(nodeIndex.size(), NONE);
+    vector<uint32_t> nextOffset(nodeIndex.size());
+    vector<uint32_t> byNum(1, NONE);
+    vector<vector<uint32_t> > frondsByTarget(1);
+    vector<uint32_t> path;
+    auto insertLow = [&low1, &low2](const uint32_t &pos, const uint32_t &visit) {
+        if (visit < low1[pos]) {
+            low2[pos] = low1[pos];
+            low1[pos] = visit;
+        } else if (visit > low1[pos] && visit < low2[pos]) {
+            low2[pos] = visit;
+        }
+    };
+    auto discover = [&](const uint32_t &pos, const uint32_t &parentPos) {
+        num[pos] = byNum.size();
+        byNum.push_back(pos);
+        frondsByTarget.push_back(vector<uint32_t>());
+        parent[pos] = parentPos;
+        low1[pos] = low2[pos] = num[pos];
+        nextOffset[pos] = nodeIndex[pos].offset;
+        path.push_back(pos);
+    };
+    discover(root, NONE);
+    while (!path.empty()) {
+        uint32_t pos = path.back();
+        uint32_t nextNodeOffset = getSlotEnd(pos);
+        if (nextOffset[pos] < nextNodeOffset) {
+            uint32_t neighborPos = getPos((*edgeBuffer)[nextOffset[pos]++]);
+            if (nodeIndex[neighborPos].removed) {
+                continue;
+            }
+            if (!num[neighborPos]) {
+                discover(neighborPos, pos);
+            } else if (neighborPos != parent[pos] && num[neighborPos] < num[pos]) {
+                own[pos] = min(own[pos], num[neighborPos]);
+                frondsByTarget[num[neighborPos]].push_back(pos);
+                insertLow(pos, num[neighborPos]);
+            }
+            continue;
+        }
+        path.pop_back();
+        if (parent[pos] != NONE) {
+            nd[parent[pos]] += nd[pos];
+            insertLow(parent[pos], low1[pos]);
+            insertLow(parent[pos], low2[pos]);
+        }
+    }
+    uint32_t nodes = byNum.size() - 1;
 
-    struct Edge {
-        uint32_t node;
-        uint32_t neighbor;
+    /* Separation pairs of the first kind */
+    for (uint32_t visit = 2 ; visit <= nodes ; visit++) {
+        uint32_t r = byNum[visit];
+        uint32_t b = parent[r];
+        if (low1[r] < num[b] && low2[r] >= num[b] && nodes > nd[r] + 2) {
+            pairs.push_back(make_pair(getNode(byNum[low1[r]]), getNode(b)));
+        }
+    }
 
-        Edge(const uint32_t &node, const uint32_t &neighbor) : node(node), neighbor(neighbor) {}
+    /* highest[b] is the highest frond target above b of the subtree of b without b, or 0 if there is none.
+     * Fronds are visited from the highest target down, and assign it to the nodes between their ends that do not have one yet.
+     * up skips over the nodes that do */
+    vector<uint32_t> highest(nodeIndex.size(), 0);
+    vector<uint32_t> up(nodeIndex.size());
+    for (uint32_t visit = 1 ; visit <= nodes ; visit++) {
+        up[byNum[visit]] = byNum[visit];
+    }
+    auto findUp = [&up](uint32_t pos) {
+        uint32_t top = pos;
+        while (top != NONE && up[top] != top) {
+            top = up[top];
+        }
+        while (pos != top) {
+            uint32_t next = up[pos];
+            up[pos] = top;
+            pos = next;
+        }
+        return top;
     };
+    for (uint32_t target = nodes ; target >= 1 ; target--) {
+        for (auto source: frondsByTarget[target]) {
+            uint32_t pos = findUp(parent[source]);
+            while (pos != NONE && num[pos] > target) {
+                highest[pos] = target;
+                up[pos] = parent[pos];
+                pos = findUp(pos);
+            }
+        }
+    }
 
-    struct Value2 {
-        Value2(const uint32_t &visit) : visit(visit), low1(visit), low2(visit), high(visit) {}
-        uint32_t visit;
-        uint32_t low1;
-        uint32_t low2;
-        uint32_t high;
+    /* Smallest own frond target over ranges of preorder numbers, where subtrees are consecutive */
+    vector<vector<uint32_t> > minOwn(1, vector<uint32_t>(nodes + 1, NONE));
+    for (uint32_t visit = 1 ; visit <= nodes ; visit++) {
+        minOwn[0][visit] = own[byNum[visit]];
+    }
+    for (uint32_t level = 1 ; (1u << level) <= nodes ; level++) {
+        minOwn.push_back(vector<uint32_t>(nodes + 1, NONE));
+        const vector<uint32_t> &previous = minOwn[level-1];
+        for (uint32_t visit = 1 ; visit + (1u << level) <= nodes + 1 ; visit++) {
+            minOwn[level][visit] = min(previous[visit], previous[visit + (1u << (level-1))]);
+        }
+    }
+    auto getMinOwn = [&minOwn](const uint32_t &begin, const uint32_t &end) {
+        if (begin >= end) {
+            return NONE;
+        }
+        uint32_t level = 31 - __builtin_clz(end - begin);
+        return min(minOwn[level][begin], minOwn[level][end - (1u << level)]);
     };
 
-    struct Instance {
-        Instance(const uint32_t &node) : node(node), curNeighborIndex(0) {}
-        uint32_t node;
-        uint32_t curNeighborIndex;
+    /* Separation pairs of the second kind. The child of a towards b is the last child of a numbered up to b */
+    vector<uint32_t> childrenOffset(nodes + 2, 0);
+    for (uint32_t visit = 2 ; visit <= nodes ; visit++) {
+        childrenOffset[num[parent[byNum[visit]]] + 1]++;
+    }
+    for (uint32_t visit = 1 ; visit <= nodes ; visit++) {
+        childrenOffset[visit + 1] += childrenOffset[visit];
+    }
+    vector<uint32_t> children(nodes);
+    vector<uint32_t> childrenEnd(childrenOffset.begin(), childrenOffset.end() - 1);
+    for (uint32_t visit = 2 ; visit <= nodes ; visit++) {
+        children[childrenEnd[num[parent[byNum[visit]]]]++] = visit;
+    }
+    auto checkSecondKind = [&](const uint32_t &a, const uint32_t &b) {
+        auto begin = children.begin() + childrenOffset[num[a]];
+        auto end = children.begin() + childrenOffset[num[a] + 1];
+        uint32_t r = byNum[*(upper_bound(begin, end, num[b]) - 1)];
+        uint32_t betweenNodes = nd[r] - nd[b];
+        if (nodes > betweenNodes + 2 && getMinOwn(num[r], num[b]) >= num[a] && getMinOwn(num[b] + nd[b], num[r] + nd[r]) >= num[a]) {
+            pairs.push_back(make_pair(getNode(a), getNode(b)));
+        }
     };
-
-    vector<vector<Edge> > buckets(2 * numberOfNodes + 1, vector<Edge>());
-    assert(buckets.size() == 2 * numberOfNodes + 1);
-    for (auto &arc: bothPalmTrees) {
-        uint32_t v = arc.first;
-        for (auto w: arc.second) {
-            auto res = palmTree2.find(v);
-            bool edgeExists = false;
-            if (res != palmTree2.end()) {
-                for (auto n: res->second) {
-                    if (n == w) {
-                        edgeExists = true;
-                        buckets[2 * oldExploredSet.find(w)->second.visit + 1].push_back(Edge(v, w));
-                    }
-                }
-            }
-            if (!edgeExists) {
-                auto itW = oldExploredSet.find(w);
-                if (itW->second.low2 < oldExploredSet.find(v)->second.visit) {
-                    buckets[2 * itW->second.low1].push_back(Edge(v, w));
-                } else {
-                    buckets[2 * itW->second.low1 + 1].push_back(Edge(v, w));
-                }
-            }
+    for (uint32_t visit = 3 ; visit <= nodes ; visit++) {
+        uint32_t b = byNum[visit];
+        if (parent[parent[b]] == NONE) {
+            continue;
         }
-    }
-    unordered_map<uint32_t, vector<uint32_t> > sortedPalmTree;
-    for (auto &bucket: buckets) {
-        for (auto &edge: bucket) {
-            auto it = sortedPalmTree.find(edge.node);
-            if (it != sortedPalmTree.end()) {
-                it->second.push_back(edge.neighbor);
-            } else {
-                vector<uint32_t> tmp;
-                tmp.push_back(edge.neighbor);
-                sortedPalmTree.insert({edge.node, tmp});
-            }
-        }
-    }
-
-    uint32_t visit = numberOfNodes;
-    unordered_map<uint32_t, Value2> exploredSet;
-    stack<Instance> frontier;
-    uint32_t root = visitToId.find(1)->second;
-    if (exploredSet.find(root) == exploredSet.end()) {
-        frontier.push(Instance(root));
-        while (!frontier.empty()) {
-            uint32_t node = frontier.top().node;
-            exploredSet.insert({node, Value2(visit - oldExploredSet.find(node)->second.nd)});
-            bool newCall;
-            do {
-                node = frontier.top().node;
-                uint32_t &curNeighborIndex = frontier.top().curNeighborIndex;
-                newCall = false;
-                while (curNeighborIndex < sortedPalmTree.find(node)->second.size()) {
-                    uint32_t neighbor = sortedPalmTree.find(node)->second.at(curNeighborIndex);
-                    auto it = exploredSet.find(neighbor);
-                    if (it == exploredSet.end()) {
-                        newCall = true;
-                        frontier.push(Instance(neighbor));
-                        break;
-                    } else {
-                        auto itV = exploredSet.find(node);
-                        if (neighbor != root) {
-                            auto itW = exploredSet.find(fathers.find(neighbor)->second);
-                            if (itV->second.visit > itW->second.high) {
-                                itW->second.high = itV->second.visit;
-                            }
-                        }
-                        auto itW = exploredSet.find(neighbor);
-                        if (itW->second.visit < itV->second.low1) {
-                            itV->second.low2 = itV->second.low1;
-                            itV->second.low1 = itW->second.visit;
-                        } else if (itW->second.visit > itV->second.low1 && itW->second.visit < itV->second.low2) {
-                            itV->second.low2 = itW->second.visit;
-                        }
-                    }
-                    curNeighborIndex++;
-                }
-                if (!newCall) {
-                    uint32_t neighbor = frontier.top().node;
-                    frontier.pop();
-                    if (!frontier.size()) {
-                        break;
-                    }
-                    node = frontier.top().node;
-                    auto itVSons = sons.find(exploredSet.find(node)->second.visit);
-                    auto itW = exploredSet.find(neighbor);
-                    if (itVSons->second == 0) {
-                        itVSons->second = itW->second.visit;
-                    }
-                    visit--;
-                    auto itV = exploredSet.find(node);
-                    if (itW->second.low1 < itV->second.low1) {
-                        itV->second.low2 = itV->second.low1;
-                        if (itW->second.low2 < itV->second.low2) {
-                            itV->second.low2 = itW->second.low2;
-                        }
-                        itV->second.low1 = itW->second.low1;
-                    } else if (itW->second.low1 == itV->second.low1) {
-                        if (itW->second.low2 < itV->second.low2) {
-                            itV->second.low2 = itW->second.low2;
-                        }
-                    } else if (itW->second.low1 < itV->second.low2) {
-                        itV->second.low2 = itW->second.low1;
-                    }
-                    frontier.top().curNeighborIndex++;
-                }
-            } while (!newCall);
-        }
-    }
-
-    for (auto &edge: sortedPalmTree) {
-        uint32_t b = edge.first;
-        uint32_t visitB = exploredSet.find(b)->second.visit;
-        for (auto r: edge.second) {
-            auto itR = exploredSet.find(r);
-            uint32_t low1R = itR->second.low1;
-            uint32_t low2R = itR->second.low2;
-            if (low2R >= visitB) {
-                for (auto &a: exploredSet) {
-                    if (a.second.visit < visitB && low1R == a.second.visit) {
-                        auto descendantsR = descendants.find(r);
-                        for (auto &node: exploredSet) {
-                            if (node.first != a.first && node.first != b && node.first != r && (descendantsR == descendants.end() || descendantsR->second.find(node.first) == descendantsR->second.end())) {
-                                //cout << "Separating pair " << a.first << "-" << b << endl;
-                                unordered_set<uint32_t> cut;
-                                cut.insert(a.first);
-                                cut.insert(b);
-                                if (checkSeparation(cut, component1, component2, actualComponent1)) {
-                                    vertexCut = cut;
-                                    //cout << "Separating pair " << a.first << "-" << b << endl;
-                                    return true;
-                                }
-                                break;
-                            }
-                        }
-                    }
-                }
-            }
+        uint32_t lowest = parent[parent[b]];
+        if (highest[b] && highest[b] < num[lowest]) {
+            checkSecondKind(byNum[highest[b]], b);
+        }
+        if (num[lowest] >= highest[b]) {
+            checkSecondKind(lowest, b);
         }
     }
-    return false;
+    sort(pairs.begin(), pairs.end());
+    pairs.erase(unique(pairs.begin(), pairs.end()), pairs.end());
 }
 
-bool Graph::getSeparatingTriplets(unordered_set<uint32_t> &vertexCut, vector<uint32_t> &component1, vector<uint32_t> &component2, bool &actualComponent1) const {
-    return false;
-    for (uint32_t pos1 = 0 ; pos1 < nodeIndex.size() ; pos1++) {
-        if (nodeIndex[pos1].removed || !nodeIndex[pos1].edges) {
+/* Find node triplets that cut off a side of at most MAX_TRIPLET_SIDE nodes. A side is grown from every node, each time taking the
+ * node of its boundary that adds the fewest new nodes to the boundary, and whenever the boundary has 3 nodes and there
+ * are nodes beyond it, it is a candidate. The boundary shrinks by at most one node per step, so growing stops once it
+ * cannot get down to 3 within the side limit. Sides that are not grown this way are missed, and each triplet is checked
+ * with checkSeparation by the caller */
+void Graph::findSeparatingTriplets(vector<vector<uint32_t> > &triplets) const {
+    triplets.clear();
+    uint32_t nodes = 0;
+    for (uint32_t pos = 0 ; pos < nodeIndex.size() ; pos++) {
+        if (!nodeIndex[pos].removed) {
+            nodes++;
+        }
+    }
+    /* Nodes are in the side or boundary of the current seed if their stamp is the seed's position plus 1 */
+    vector<uint32_t> sideStamp(nodeIndex.size(), 0);
+    vector<uint32_t> boundaryStamp(nodeIndex.size(), 0);
+    vector<uint32_t> boundary;
+    /* Positions of the neighbors of pos that are neither in the side nor in the boundary */
+    auto gatherOutside = [this, &sideStamp, &boundaryStamp](const uint32_t &pos, const uint32_t &stamp, vector<uint32_t> &outside) {
+        outside.clear();
+        uint32_t nextNodeOffset = getSlotEnd(pos);
+        for (uint32_t offset = nodeIndex[pos].offset ; offset < nextNodeOffset ; offset++) {
+            uint32_t neighborPos = getPos((*edgeBuffer)[offset]);
+            if (!nodeIndex[neighborPos].removed && sideStamp[neighborPos] != stamp && boundaryStamp[neighborPos] != stamp) {
+                outside.push_back(neighborPos);
+            }
+        }
+    };
+    vector<uint32_t> outside;
+    for (uint32_t seed = 0 ; seed < nodeIndex.size() ; seed++) {
+        if (nodeIndex[seed].removed || !nodeIndex[seed].edges) {
             continue;
         }
-        for (uint32_t pos2 = pos1+1 ; pos2 < nodeIndex.size() ; pos2++) {
-            if (nodeIndex[pos2].removed || !nodeIndex[pos2].edges) {
-                continue;
+        uint32_t stamp = seed + 1;
+        uint32_t sideSize = 0;
+        uint32_t next = seed;
+        boundary.clear();
+        while (true) {
+            sideStamp[next] = stamp;
+            sideSize++;
+            gatherOutside(next, stamp, outside);
+            for (auto neighborPos: outside) {
+                boundaryStamp[neighborPos] = stamp;
+                boundary.push_back(neighborPos);
             }
-            for (uint32_t pos3 = pos2+1 ; pos3 < nodeIndex.size() ; pos3++) {
-                if (nodeIndex[pos3].removed || !nodeIndex[pos3].edges) {
-                    continue;
+            if (boundary.size() == 3 && sideSize + 3 < nodes) {
+                vector<uint32_t> triplet;
+                for (auto pos: boundary) {
+                    triplet.push_back(getNode(pos));
                 }
-                unordered_set<uint32_t> excludedNodes;
-                excludedNodes.insert((!mapping ? pos1 : posToId->at(pos1)));
-                excludedNodes.insert((!mapping ? pos2 : posToId->at(pos2)));
-                excludedNodes.insert((!mapping ? pos3 : posToId->at(pos3)));
-                if (checkSeparation(excludedNodes, component1, component2, actualComponent1)) {
-                    vertexCut = excludedNodes;
-                    return true;
+                sort(triplet.begin(), triplet.end());
+                triplets.push_back(triplet);
+            }
+            if (sideSize == MAX_TRIPLET_SIDE || boundary.empty() || boundary.size() > 3 + MAX_TRIPLET_SIDE - sideSize) {
+                break;
+            }
+            uint32_t bestIndex = 0;
+            uint32_t bestGrowth = NONE;
+            for (uint32_t i = 0 ; i < boundary.size() && bestGrowth ; i++) {
+                gatherOutside(boundary[i], stamp, outside);
+                if (outside.size() < bestGrowth) {
+                    bestIndex = i;
+                    bestGrowth = outside.size();
                 }
             }
+            next = boundary[bestIndex];
+            boundary[bestIndex] = boundary.back();
+            boundary.pop_back();
         }
     }
-    return false;
+    sort(triplets.begin(), triplets.end());
+    triplets.erase(unique(triplets.begin(), triplets.end()), triplets.end());
 }
 
 bool Graph::checkSeparation(const unordered_set<uint32_t> &cut, vector<uint32_t> &component1, vector<uint32_t> &component2, bool &actualComponent1) const {
@@ -1657,9 +1786,9 @@ bool Graph::checkSeparation(const unordered_set<uint32_t> &cut, vector<uint32_t>
         }
         return true;
     } else {
-        if (component1.size() <= 24) {
+        if (component1.size() <= MAX_TRIPLET_SIDE) {
             actualComponent1 = true;
-        } else if (component2.size() <= 24) {
+        } else if (component2.size() <= MAX_TRIPLET_SIDE) {
             actualComponent1 = false;
         } else {
             return false;
@@ -1676,6 +1805,42 @@ bool Graph::checkSeparation(const unordered_set<uint32_t> &cut, vector<uint32_t>
     }
 }
 
+/* Split the nodes with edges into the connected component of the first one, and the rest.
+ * Return false if there is no rest, i.e. the graph is connected */
+bool Graph::splitComponent(vector<uint32_t> &component, vector<uint32_t> &rest) const {
+    component.clear();
+    rest.clear();
+    vector<bool> explored(nodeIndex.size(), false);
+    for (uint32_t pos = 0 ; pos < nodeIndex.size() ; pos++) {
+        if (nodeIndex[pos].removed || !nodeIndex[pos].edges) {
+            continue;
+        }
+        if (!component.size()) {
+            explored[pos] = true;
+            component.push_back(getNode(pos));
+            for (uint32_t i = 0 ; i < component.size() ; i++) {
+                uint32_t cPos = getPos(component[i]);
+                uint32_t nextNodeOffset = getSlotEnd(cPos);
+                uint32_t edges = 0;
+                for (uint32_t offset = nodeIndex[cPos].offset ; offset < nextNodeOffset && edges < nodeIndex[cPos].edges ; offset++) {
+                    uint32_t nPos = getPos((*edgeBuffer)[offset]);
+                    if (nodeIndex[nPos].removed) {
+                        continue;
+                    }
+                    edges++;
+                    if (!explored[nPos]) {
+                        explored[nPos] = true;
+                        component.push_back((*edgeBuffer)[offset]);
+                    }
+                }
+            }
+        } else if (!explored[pos]) {
+            rest.push_back(getNode(pos));
+        }
+    }
+    return rest.size();
+}
+
 /* Only builds 2 CCs, optimized for separation set detection */
 bool Graph::buildCC(const unordered_set<uint32_t> &excludedNodes, vector<uint32_t> &component1, vector<uint32_t> &component2) const {
     component1.clear();
@@ -1713,13 +1878,7 @@ bool Graph::buildCC(const unordered_set<uint32_t> &excludedNodes, vector<uint32_
 }
 
 uint32_t Graph::getNodeCountWithEdges() const {
-    uint32_t count = 0;
-    for (auto &node: nodeIndex) {
-        if (!node.removed && node.edges) {
-            count++;
-        }
-    }
-    return count;
+    return degreeBuckets.nodes - getDegreeCount(0);
 }
 
 void Graph::print(bool direction) const {
@@ -1730,9 +1889,9 @@ void Graph::print(bool direction) const {
             if (!nodeIndex[pos].edges) {
                 cout << node << "\n";
             }
-            uint32_t nextNodeOffset = (pos == nodeIndex.size()-1 ? edgeBuffer->size() : nodeIndex[pos+1].offset);
+            uint32_t nextNodeOffset = getSlotEnd(pos);
             for (uint32_t offset = nodeIndex[pos].offset ; offset < nextNodeOffset ; offset++) {
-                uint32_t nPos = (!mapping ? (*edgeBuffer)[offset] : idToPos->at((*edgeBuffer)[offset]));
+                uint32_t nPos = (!mapping ? (*edgeBuffer)[offset] : (*idToPos)[(*edgeBuffer)[offset]]);
                 if (!nodeIndex[nPos].removed && (direction || !direction && node < (*edgeBuffer)[offset])) {
                     cout << node << "\t" << (*edgeBuffer)[offset] << "\n";
                 }
@@ -1774,35 +1933,172 @@ void Graph::printEdgeCounts() const {
 
 /* Build graph from file, include both edge directions, keep them sorted.
  * Zero degree nodes are included in nodeIndex, but are makred as removed.
- * They are also held on zeroDegreeNodes seperate structure */
-Graph::Graph(const string &inputFile, const bool &checkIndependentSet) : mapping(false), idToPos(NULL), posToId(NULL) {
-    /* Open graph input file */
-    FILE *f;
-    f = fopen(inputFile.c_str(), "r");
-    if (f == NULL) {
+ * They are also held on zeroDegreeNodes seperate structure.
+ * The file is mapped to memory, and holds either a SNAP edge list or the binary format of writeBinary() */
+Graph::Graph(const string &inputFile, const Options &options, vector<uint32_t> &inputIds) : mapping(false), trailEnabled(false), touchedNodes(NULL) {
+    int fd = open(inputFile.c_str(), O_RDONLY);
+    if (fd == -1) {
         cerr << "Error in opening input file " << inputFile << endl;
         exit(EXIT_FAILURE);
     }
-    char buf[MAXLINE];
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == -1 || !fileStat.st_size) {
+        cerr << "Error in parsing input file " << inputFile << endl;
+        exit(EXIT_FAILURE);
+    }
+    size_t fileSize = fileStat.st_size;
+    const char *file = (const char *) mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (file == MAP_FAILED) {
+        cerr << "Error in mapping input file " << inputFile << endl;
+        exit(EXIT_FAILURE);
+    }
+    madvise((void *) file, fileSize, MADV_SEQUENTIAL);
+    IdCompaction compaction;
+    if (fileSize >= sizeof(BinaryHeader) && !memcmp(file, BINARY_MAGIC, sizeof(BinaryHeader::magic))) {
+        readBinary(file, fileSize, inputFile);
+        if (options.compact) {
+            compactNodes(compaction);
+        }
+    } else {
+        readEdgeList(file, file + fileSize, inputFile, (uint64_t) options.loadMemory << 20, (options.compact ? &compaction : NULL));
+    }
+    munmap((void *) file, fileSize);
+    close(fd);
+    inputIds.clear();
+    if (options.compact) {
+        compaction.getIds(inputIds);
+    }
+    if (options.reorder) {
+        relabel(inputIds);
+    }
+    for (uint32_t node = 0 ; node < nodeIndex.size() ; node++) {
+        if (!nodeIndex[node].edges && !options.checkIndependentSet) {
+            zeroDegreeNodes.push_back(node);
+            nodeIndex[node].removed = true;
+        }
+    }
+    nextUnusedId = nodeIndex.size();
+    buildDegreeBuckets();
+}
 
-    /* Skip info lines */
-    for (int i = 0 ; i < 3 ; i++) {
-        if (fgets(buf, MAXLINE, f) == NULL) {
-            cerr << "Error in parsing input file " << inputFile << endl;
+/* Parse a SNAP edge list, in any edge order, with duplicate edges and self loops dropped. The node and edge numbers of
+ * the info lines are only taken as hints, and the graph has as many nodes as its largest id needs. Edge lines are parsed
+ * in segments whose edges fit in loadMemory bytes. A single segment is laid out directly, while larger files are sorted
+ * segment by segment into runs on disk, which are merged into the adjacency lists. With a compaction, the graph only
+ * has the ids that occur in the edge list, renumbered densely in the same order */
+void Graph::readEdgeList(const char *file, const char *end, const string &inputFile, const uint64_t &loadMemory, IdCompaction *compaction) {
+    uint32_t nodes = 0;
+    uint64_t edges = 0;
+    const char *line = file;
+    while (line < end && *line == '#') {
+        const char *next = (const char *) memchr(line, '\n', end - line);
+        next = (next == NULL ? end : next + 1);
+        string info(line, next - line);
+        size_t nodesInfo = info.find("Nodes:");
+        size_t edgesInfo = info.find("Edges:");
+        if (nodesInfo != string::npos) {
+            nodes = strtoul(info.c_str() + nodesInfo + 6, NULL, 10);
+        }
+        if (edgesInfo != string::npos) {
+            edges = strtoull(info.c_str() + edgesInfo + 6, NULL, 10);
+        }
+        line = next;
+    }
+
+    /* Every edge line has at least 4 characters, and takes 16 bytes once both of its directions are in a run */
+    size_t segmentSize = max((uint64_t) MIN_CHUNK, loadMemory / 4);
+    vector<vector<uint32_t> > chunkEdges;
+    if ((size_t) (end - line) <= segmentSize) {
+        nodes = max(nodes, parseSegment(line, end, min(2 * edges, (uint64_t) (end - line) / 2), chunkEdges));
+        if (compaction != NULL) {
+            for (auto &chunk: chunkEdges) {
+                for (auto node: chunk) {
+                    compaction->mark(node);
+                }
+            }
+            nodes = compaction->finish();
+            for (auto &chunk: chunkEdges) {
+                for (auto &node: chunk) {
+                    node = compaction->getDenseId(node);
+                }
+            }
+        }
+        buildFromEdges(chunkEdges, nodes);
+        return;
+    }
+    vector<FILE *> runs;
+    vector<uint64_t> run;
+    while (line < end) {
+        const char *segmentEnd = line + min(segmentSize, (size_t) (end - line));
+        const char *next = (const char *) memchr(segmentEnd - 1, '\n', end - (segmentEnd - 1));
+        segmentEnd = (next == NULL ? end : next + 1);
+        parseSegment(line, segmentEnd, 0, chunkEdges);
+        line = segmentEnd;
+
+        /* Both directions of each edge as source << 32 | target, sorted and without duplicates */
+        run.clear();
+        for (auto &chunk: chunkEdges) {
+            for (size_t i = 0 ; i < chunk.size() ; i += 2) {
+                if (compaction != NULL) {
+                    compaction->mark(chunk[i]);
+                    compaction->mark(chunk[i+1]);
+                }
+                if (chunk[i] != chunk[i+1]) {
+                    run.push_back((uint64_t) chunk[i] << 32 | chunk[i+1]);
+                    run.push_back((uint64_t) chunk[i+1] << 32 | chunk[i]);
+                }
+            }
+            vector<uint32_t>().swap(chunk);
+        }
+        sort(run.begin(), run.end());
+        run.erase(unique(run.begin(), run.end()), run.end());
+        FILE *f = tmpfile();
+        if (f == NULL || fwrite(run.data(), sizeof(uint64_t), run.size(), f) != run.size() || fflush(f)) {
+            cerr << "Error in writing a sorted run of input file " << inputFile << " to a temporary file" << endl;
             exit(EXIT_FAILURE);
         }
+        rewind(f);
+        runs.push_back(f);
     }
-
-    /* Get total node and edge numbers */
-    char *ptr = strstr(buf, "Nodes:");
-    uint32_t nodes = atoi(ptr + 7);
-    ptr = strstr(buf, "Edges:");
-    uint32_t edges = atoi(ptr + 7);
-    if (fgets(buf, MAXLINE, f) == NULL) {
-        cerr << "Error in parsing input file " << inputFile << endl;
-        exit(EXIT_FAILURE);
+    vector<uint64_t>().swap(run);
+    if (compaction != NULL) {
+        nodes = compaction->finish();
     }
+    mergeRuns(runs, nodes, compaction);
+}
 
+/* Parse the edge lines between begin and end into one list of edges per thread, on chunks of at least MIN_CHUNK bytes
+ * cut at line ends. reserveEdges is a hint of the ids that the first chunk will hold. Return the number of nodes that
+ * the ids need */
+uint32_t Graph::parseSegment(const char *begin, const char *end, const uint64_t &reserveEdges, vector<vector<uint32_t> > &chunkEdges) {
+    uint32_t threads = max(1U, thread::hardware_concurrency());
+    threads = max((size_t) 1, min((size_t) threads, (end - begin) / MIN_CHUNK));
+    vector<const char *> chunkBegin(threads + 1, end);
+    chunkBegin[0] = begin;
+    for (uint32_t i = 1 ; i < threads ; i++) {
+        const char *cut = max(chunkBegin[i-1], begin + (end - begin) / threads * i);
+        const char *next = (const char *) memchr(cut, '\n', end - cut);
+        chunkBegin[i] = (next == NULL ? end : next + 1);
+    }
+    chunkEdges.assign(threads, vector<uint32_t>());
+    vector<uint32_t> chunkNodes(threads);
+    vector<thread> parsers;
+    for (uint32_t i = 1 ; i < threads ; i++) {
+        parsers.push_back(thread([&, i]() {
+            chunkNodes[i] = parseEdges(chunkBegin[i], chunkBegin[i+1], chunkEdges[i]);
+        }));
+    }
+    chunkEdges[0].reserve(reserveEdges / threads);
+    chunkNodes[0] = parseEdges(chunkBegin[0], chunkBegin[1], chunkEdges[0]);
+    for (auto &parser: parsers) {
+        parser.join();
+    }
+    return *max_element(chunkNodes.begin(), chunkNodes.end());
+}
+
+/* Lay out the adjacency lists by degree, then scatter the edges in file order. The lists come out sorted for files
+ * sorted by source, and are only sorted here otherwise. Duplicate edges are then squeezed out in place */
+void Graph::buildFromEdges(vector<vector<uint32_t> > &chunkEdges, const uint32_t &nodes) {
     try {
         nodeIndex.reserve(nodes);
     }
@@ -1810,101 +2106,244 @@ Graph::Graph(const string &inputFile, const bool &checkIndependentSet) : mapping
         cerr << "NodeIndex length error: " << le.what() << endl;
         exit(EXIT_FAILURE);
     }
+    vector<uint32_t> next(nodes, 0);
+    uint64_t totalEdges = 0;
+    for (auto &chunk: chunkEdges) {
+        for (size_t i = 0 ; i < chunk.size() ; i += 2) {
+            if (chunk[i] != chunk[i+1]) {
+                next[chunk[i]]++;
+                next[chunk[i+1]]++;
+                totalEdges += 2;
+            }
+        }
+    }
+    edgeBuffer = make_shared<vector<uint32_t> >();
+    try {
+        edgeBuffer->resize(totalEdges);
+    }
+    catch (const length_error &le) {
+        cerr << "EdgeBuffer length error: " << le.what() << endl;
+        exit(EXIT_FAILURE);
+    }
+    uint32_t offset = 0;
+    for (uint32_t node = 0 ; node < nodes ; node++) {
+        nodeIndex.push_back(Graph::NodeInfo(offset, next[node]));
+        next[node] = offset;
+        offset += nodeIndex[node].edges;
+    }
+    vector<uint32_t> &edgeBuffer = *this->edgeBuffer;
+    for (auto &chunk: chunkEdges) {
+        for (size_t i = 0 ; i < chunk.size() ; i += 2) {
+            if (chunk[i] != chunk[i+1]) {
+                edgeBuffer[next[chunk[i]]++] = chunk[i+1];
+                edgeBuffer[next[chunk[i+1]]++] = chunk[i];
+            }
+        }
+        vector<uint32_t>().swap(chunk);
+    }
+    offset = 0;
+    for (uint32_t node = 0 ; node < nodes ; node++) {
+        auto begin = edgeBuffer.begin() + nodeIndex[node].offset;
+        auto end = begin + nodeIndex[node].edges;
+        if (!is_sorted(begin, end)) {
+            sort(begin, end);
+        }
+        uint32_t uniqueEdges = 0;
+        for (auto edge = begin ; edge != end ; edge++) {
+            if (edge == begin || *edge != *(edge - 1)) {
+                edgeBuffer[offset + uniqueEdges++] = *edge;
+            }
+        }
+        nodeIndex[node].offset = offset;
+        nodeIndex[node].edges = uniqueEdges;
+        nodeIndex[node].capacity = uniqueEdges;
+        offset += nodeIndex[node].edges;
+    }
+    edgeBuffer.resize(offset);
+}
 
-    edgeBuffer = new vector<uint32_t>();
+/* Merge sorted runs of source << 32 | target into the adjacency lists, which are filled in node order, skipping the
+ * duplicates across runs. Each run is read through a buffer of RUN_BUFFER entries, and closed, which deletes it.
+ * A compaction renumbers both ends of each edge, which keeps their order */
+void Graph::mergeRuns(vector<FILE *> &runs, const uint32_t &nodes, const IdCompaction *compaction) {
+    const size_t RUN_BUFFER = 1 << 16;
+    vector<vector<uint64_t> > buffers(runs.size());
+    vector<size_t> position(runs.size(), 0);
+    auto refill = [&](const uint32_t &run) {
+        buffers[run].resize(RUN_BUFFER);
+        buffers[run].resize(fread(buffers[run].data(), sizeof(uint64_t), RUN_BUFFER, runs[run]));
+        position[run] = 0;
+        return !buffers[run].empty();
+    };
+    typedef pair<uint64_t, uint32_t> Head;
+    priority_queue<Head, vector<Head>, greater<Head> > heads;
+    uint64_t totalEdges = 0;
+    for (uint32_t run = 0 ; run < runs.size() ; run++) {
+        fseek(runs[run], 0, SEEK_END);
+        totalEdges += ftell(runs[run]) / sizeof(uint64_t);
+        rewind(runs[run]);
+        if (refill(run)) {
+            heads.push(Head(buffers[run][0], run));
+        }
+    }
+    edgeBuffer = make_shared<vector<uint32_t> >();
     try {
-        edgeBuffer->reserve(edges * 2);
+        edgeBuffer->reserve(totalEdges);
     }
     catch (const length_error &le) {
         cerr << "EdgeBuffer length error: " << le.what() << endl;
         exit(EXIT_FAILURE);
     }
+    uint64_t previous = UINT64_MAX;
+    while (!heads.empty()) {
+        Head head = heads.top();
+        heads.pop();
+        uint32_t run = head.second;
+        if (++position[run] < buffers[run].size() || refill(run)) {
+            heads.push(Head(buffers[run][position[run]], run));
+        }
+        if (head.first == previous) {
+            continue;
+        }
+        previous = head.first;
+        uint32_t source = head.first >> 32;
+        uint32_t target = (uint32_t) head.first;
+        if (compaction != NULL) {
+            source = compaction->getDenseId(source);
+            target = compaction->getDenseId(target);
+        }
+        while (nodeIndex.size() <= source) {
+            nodeIndex.push_back(Graph::NodeInfo(edgeBuffer->size(), 0));
+        }
+        edgeBuffer->push_back(target);
+        nodeIndex[source].edges++;
+        nodeIndex[source].capacity++;
+    }
+    for (auto f: runs) {
+        fclose(f);
+    }
+    while (nodeIndex.size() < nodes) {
+        nodeIndex.push_back(Graph::NodeInfo(edgeBuffer->size(), 0));
+    }
+}
 
-    /* Hold reverse direction edges temporarily */
-    vector<vector<uint32_t> > reverseEdges(nodes);
+/* Keep only the nodes with edges, renumbered densely in the same order. Their edges stay where they are in the
+ * edge buffer, and only the ids in it are renumbered */
+void Graph::compactNodes(IdCompaction &compaction) {
+    for (uint32_t node = 0 ; node < nodeIndex.size() ; node++) {
+        if (nodeIndex[node].edges) {
+            compaction.mark(node);
+        }
+    }
+    compaction.finish();
+    vector<NodeInfo> nodeIndex;
+    for (uint32_t node = 0 ; node < this->nodeIndex.size() ; node++) {
+        if (this->nodeIndex[node].edges) {
+            nodeIndex.push_back(this->nodeIndex[node]);
+        }
+    }
+    this->nodeIndex.swap(nodeIndex);
+    for (auto &edge: *edgeBuffer) {
+        edge = compaction.getDenseId(edge);
+    }
+}
 
-    /* Build graph with both edge directions, keep them sorted */
-    uint32_t sourceNode, targetNode, previousNode, straightEdges, offset;
-    previousNode = NONE;
-    straightEdges = 0;
-    offset = 0;
-    while(fgets(buf, MAXLINE, f) != NULL) {
-        parseNodeIDs(buf, &sourceNode, &targetNode);
-        if (sourceNode >= nodes || targetNode >= nodes) {
-            cerr << "Error: received a node id equal or larger than the total nodes number specified at the beginning of the file" << endl;
+/* Load the arrays of writeBinary() with one copy each, after checking that they are consistent with each other */
+void Graph::readBinary(const char *file, const size_t &fileSize, const string &inputFile) {
+    BinaryHeader header;
+    memcpy(&header, file, sizeof(BinaryHeader));
+    if (header.version != BINARY_VERSION) {
+        cerr << "Error in parsing input file " << inputFile << ": binary format version " << header.version << ", expected " << BINARY_VERSION << endl;
+        exit(EXIT_FAILURE);
+    }
+    if (fileSize != sizeof(BinaryHeader) + (2 * (uint64_t) header.nodes + header.edges) * sizeof(uint32_t)) {
+        cerr << "Error in parsing input file " << inputFile << ": binary file size does not match its header" << endl;
+        exit(EXIT_FAILURE);
+    }
+    const uint32_t *offsets = (const uint32_t *) (file + sizeof(BinaryHeader));
+    const uint32_t *degrees = offsets + header.nodes;
+    const uint32_t *edges = degrees + header.nodes;
+    nodeIndex.reserve(header.nodes);
+    for (uint32_t node = 0 ; node < header.nodes ; node++) {
+        if ((uint64_t) offsets[node] + degrees[node] > header.edges) {
+            cerr << "Error in parsing input file " << inputFile << ": edges of node " << node << " out of bounds" << endl;
             exit(EXIT_FAILURE);
         }
-        /* Add smaller nodes than first source node */
-        if (previousNode == NONE && sourceNode) {
-            this->fill(sourceNode, checkIndependentSet);
-        }
-        if (previousNode != sourceNode && previousNode != NONE) {
-            /* At new source node, add previous nodes' (including those who don't appear as source nodes) smaller neighbors */
-            for (uint32_t node = previousNode + 1 ; node <= sourceNode ; node++) {
-                uint32_t previousEdges = straightEdges + reverseEdges[node - 1].size();
-                nodeIndex.push_back(Graph::NodeInfo(offset, previousEdges));
-                if (!previousEdges && !checkIndependentSet) {
-                    zeroDegreeNodes.push_back(nodeIndex.size()-1);
-                    nodeIndex[nodeIndex.size()-1].removed = true;
-                }
-                offset += previousEdges;
-                edgeBuffer->insert(edgeBuffer->end(), reverseEdges[node].begin(), reverseEdges[node].end());
-                straightEdges = 0;
-                if (node < sourceNode) {
-                    //cout << "in between missing node " << node << endl;
-                }
-            }
+        nodeIndex.push_back(NodeInfo(offsets[node], degrees[node]));
+    }
+    for (uint64_t i = 0 ; i < header.edges ; i++) {
+        if (edges[i] >= header.nodes) {
+            cerr << "Error in parsing input file " << inputFile << ": node id " << edges[i] << " out of range" << endl;
+            exit(EXIT_FAILURE);
         }
-        /* Add source node's bigger neighbors */
-        edgeBuffer->push_back(targetNode);
-        straightEdges++;
-        reverseEdges[targetNode].push_back(sourceNode);
-        previousNode = sourceNode;
-    }
-    /* Add final source node's info */
-    uint32_t previousEdges = straightEdges + reverseEdges[previousNode].size();
-    nodeIndex.push_back(Graph::NodeInfo(offset, previousEdges));
-    if (!previousEdges && !checkIndependentSet) {
-        zeroDegreeNodes.push_back(nodeIndex.size()-1);
-        nodeIndex[nodeIndex.size()-1].removed = true;
-    }
-    offset += previousEdges;
-    /* Add smaller neighbors of the nodes left that don't appear as source nodes */
-    for (uint32_t missingNode = nodeIndex.size() ; missingNode < nodes ; missingNode++) {
-        //cout << "end missing node " << missingNode << endl;
-        previousEdges = reverseEdges[missingNode].size();
-        nodeIndex.push_back(Graph::NodeInfo(offset, previousEdges));
-        if (!previousEdges && !checkIndependentSet) {
-            zeroDegreeNodes.push_back(nodeIndex.size()-1);
-            nodeIndex[nodeIndex.size()-1].removed = true;
-        }
-        offset += previousEdges;
-        edgeBuffer->insert(edgeBuffer->end(), reverseEdges[missingNode].begin(), reverseEdges[missingNode].end());
     }
-    nextUnusedId = nodeIndex.size();
-    fclose(f);
+    edgeBuffer = make_shared<vector<uint32_t> >(edges, edges + header.edges);
 }
 
-void Graph::fill(const uint32_t &size, const bool &checkIndependentSet) {
-    //cout << "start missing nodes from " << nodeIndex.size() << " to " << size << endl;
-    while (nodeIndex.size() < size) {
-        nodeIndex.push_back(NodeInfo(edgeBuffer->size(), 0));
-        if (!checkIndependentSet) {
-            zeroDegreeNodes.push_back(nodeIndex.size()-1);
-            nodeIndex[nodeIndex.size()-1].removed = true;
-        }
+/* Write the graph as loaded, in a binary format that is read back without parsing: a BinaryHeader, then the
+ * offset of each node, the degree of each node and the edge buffer, as native 32 bit integers */
+void Graph::writeBinary(const string &outputFile) const {
+    assert(!mapping);
+    FILE *f = fopen(outputFile.c_str(), "wb");
+    if (f == NULL) {
+        cerr << "Error in opening output file " << outputFile << endl;
+        exit(EXIT_FAILURE);
+    }
+    BinaryHeader header;
+    memset(&header, 0, sizeof(BinaryHeader));
+    memcpy(header.magic, BINARY_MAGIC, sizeof(BinaryHeader::magic));
+    header.version = BINARY_VERSION;
+    header.nodes = nodeIndex.size();
+    header.edges = edgeBuffer->size();
+    vector<uint32_t> offsets(nodeIndex.size());
+    vector<uint32_t> degrees(nodeIndex.size());
+    for (uint32_t node = 0 ; node < nodeIndex.size() ; node++) {
+        offsets[node] = nodeIndex[node].offset;
+        degrees[node] = nodeIndex[node].edges;
+    }
+    bool written = fwrite(&header, sizeof(BinaryHeader), 1, f) == 1;
+    written = written && fwrite(offsets.data(), sizeof(uint32_t), offsets.size(), f) == offsets.size();
+    written = written && fwrite(degrees.data(), sizeof(uint32_t), degrees.size(), f) == degrees.size();
+    written = written && fwrite(edgeBuffer->data(), sizeof(uint32_t), edgeBuffer->size(), f) == edgeBuffer->size();
+    if (fclose(f) || !written) {
+        cerr << "Error in writing output file " << outputFile << endl;
+        exit(EXIT_FAILURE);
     }
 }
 
-void Graph::parseNodeIDs(char *buf, uint32_t *sourceNode, uint32_t *targetNode) {
-    uint32_t *node = sourceNode;
-    for (int i = 0 ; i < 2 ; i++) {
-        uint32_t id = 0;
-        for (; *buf != ' ' && *buf != '\t' && *buf != '\n' && *buf != '\0' ; buf++) {
-            id = id * 10 + (*buf - '0');
+/* Append the source and target of every edge line between begin and end to edges, skipping comment lines.
+ * Return the number of nodes that the ids need */
+uint32_t Graph::parseEdges(const char *begin, const char *end, vector<uint32_t> &edges) {
+    uint32_t nodes = 0;
+    const char *c = begin;
+    while (c < end) {
+        if (*c == '#') {
+            const char *next = (const char *) memchr(c, '\n', end - c);
+            c = (next == NULL ? end : next + 1);
+            continue;
+        }
+        uint32_t ids[2];
+        uint32_t parsed = 0;
+        while (c < end && *c != '\n') {
+            uint32_t digit = (uint8_t) *c - '0';
+            if (digit > 9) {
+                c++;
+                continue;
+            }
+            uint32_t id = digit;
+            while (++c < end && (digit = (uint8_t) *c - '0') <= 9) {
+                id = id * 10 + digit;
+            }
+            if (parsed < 2) {
+                ids[parsed++] = id;
+            }
+        }
+        c++;
+        if (parsed == 2) {
+            edges.push_back(ids[0]);
+            edges.push_back(ids[1]);
+            nodes = max(nodes, max(ids[0], ids[1]) + 1);
         }
-        *node = id;
-        node = targetNode;
-        for (; *buf == ' ' || *buf == '\t' ; buf++);
     }
+    return nodes;
 }
@@ -2,56 +2,60 @@
 #define GRAPH_H
 
 #include <iostream>
+#include <cstdio>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
 #include <set>
 #include <algorithm>
+#include <memory>
 #include <assert.h>
 #include "Util.hpp"
 
 #define MAXLINE 1024
+#define BINARY_MAGIC "MISG"
+#define BINARY_VERSION 1
 
 class Graph {
 
 friend class ControlUnit;
 friend class Reductions;
 friend class Alg;
+friend class Bounds;
+friend class Heuristic;
+friend class BitsetSolver;
 class NodeInfo;
 struct Traversal;
 
 public:
+    /* Largest small side of a 3 node cut that the search splits off */
+    static const uint32_t MAX_TRIPLET_SIDE = 24;
+
     struct GraphTraversal;
-    Graph(const std::string &inputFile, const bool &checkIndependentSet);
-    Graph() : mapping(false), idToPos(NULL), posToId(NULL) {}
+    struct BlockCutTree;
+    Graph(const std::string &inputFile, const Options &options, std::vector<uint32_t> &inputIds);
+    void writeBinary(const std::string &outputFile) const;
+    Graph() : mapping(false), trailEnabled(false), touchedNodes(NULL) {}
     Graph(const Graph &graph);
     Graph& operator=(const Graph &graph);
 
     uint32_t getNodeCountWithEdges() const;
 
     uint32_t getPos(const uint32_t &node) const {
-        return (!mapping ? node : idToPos->at(node));
+        return (!mapping ? node : (*idToPos)[node]);
     }
 
     uint32_t getNode(const uint32_t &pos) const {
         return (!mapping ? pos : posToId->at(pos));
     }
 
-    ~Graph();
-
-    void setIdToPos(std::unordered_map<uint32_t, uint32_t> *idToPos) {
-        if (this->idToPos != NULL) {
-            delete this->idToPos;
-        }
-        this->idToPos = idToPos;
+    void setIdToPos(std::vector<uint32_t> *idToPos) {
+        this->idToPos.reset(idToPos);
     }
 
     void setPosToId(std::vector<uint32_t> *posToId) {
-        if (this->posToId != NULL) {
-            delete this->posToId;
-        }
-        this->posToId = posToId;
+        this->posToId.reset(posToId);
     }
 
     void setMapping(const bool &mapping) {
@@ -59,14 +63,16 @@ public:
     }
 
     uint32_t getNodeDegree(const uint32_t &node) const {
-        uint32_t pos = (!mapping ? node : idToPos->at(node));
+        uint32_t pos = (!mapping ? node : (*idToPos)[node]);
         assert(!nodeIndex[pos].removed);
         return nodeIndex[pos].edges;
     }
 
+    void buildBlockCutTree(BlockCutTree &tree) const;
     bool getArticulationPoints(std::unordered_set<uint32_t> &vertexCut, std::vector<uint32_t> &component1, std::vector<uint32_t> &component2, bool &actualComponent1, bool &connected) const;
-    bool getSeparatingPairs(std::unordered_set<uint32_t> &vertexCut, std::vector<uint32_t> &component1, std::vector<uint32_t> &component2, bool &actualComponent1) const;
-    bool getSeparatingTriplets(std::unordered_set<uint32_t> &vertexCut, std::vector<uint32_t> &component1, std::vector<uint32_t> &component2, bool &actualComponent1) const;
+    bool splitComponent(std::vector<uint32_t> &component, std::vector<uint32_t> &rest) const;
+    void findSeparationPairs(std::vector<std::pair<uint32_t, uint32_t> > &pairs) const;
+    void findSeparatingTriplets(std::vector<std::vector<uint32_t> > &triplets) const;
     uint32_t getOptimalNodeTheta3(const uint32_t initialMaxDegreeNode, const uint32_t &initialMaxDegree) const;
     bool getEffectiveNodeOrOptimalFunnel(uint32_t &effectiveNode, uint32_t &nodeV, uint32_t &nodeA) const;
     bool get4CycleTheta3(std::vector<uint32_t> &optimalCycle) const;
@@ -88,21 +94,49 @@ public:
     void getCommonNeighbors(const uint32_t &node1, const uint32_t &node2, std::vector<uint32_t> &container, const uint32_t &atLeast= 0) const;
     void getOptimalShortEdge(const uint32_t &degree, uint32_t &finalNode1, uint32_t &finalNode2, std::vector<uint32_t> &finalSet) const;
     void getExtendedGrandchildren(Graph::GraphTraversal &graphTraversal, std::unordered_set<uint32_t> &extendedGrandchildren, bool *isUnconfined = NULL, const bool &stopAtFirst = false) const;
-    void getMaxNodeDegree(uint32_t &node, uint32_t &maxDegree, const uint32_t &bound = NONE) const;
+    void getMaxNodeDegree(uint32_t &node, uint32_t &maxDegree) const;
     void getMinDegree(uint32_t &minDegree) const;
-    uint32_t getTotalEdges() const;
+    uint32_t getMaxDegree() const {
+        return degreeBuckets.maxDegree;
+    }
+    uint32_t getDegreeCount(const uint32_t &degree) const {
+        return (degree < degreeBuckets.size.size() ? degreeBuckets.size[degree] : 0);
+    }
+    uint32_t getTotalEdges() const {
+        return degreeBuckets.totalEdges;
+    }
+    uint32_t getNodeCount() const {
+        return degreeBuckets.nodes;
+    }
     void remove(const uint32_t &node, ReduceInfo &reduceInfo, const bool &removeZeroDegreeNodes = false);
     void rebuild(ReduceInfo &reduceInfo);
     void rebuildFromNodes(std::unordered_set<uint32_t> &nodes);
+    void getBreadthFirstOrder(std::vector<uint32_t> &positions, const std::unordered_set<uint32_t> *nodes = NULL) const;
+    /* Lay out positions in breadth first order when rebuilding */
+    static bool localityOrder;
     void buildNDegreeSubgraph(const uint32_t &degree, Graph &subgraph);
     uint32_t contractToSingleNode(const std::vector<uint32_t> &nodes, const std::vector<uint32_t> &neighbors, ReduceInfo &reduceInfo);
-    uint32_t getNodeWithOneUncommonNeighbor(const std::vector<uint32_t> &neighbors, uint32_t &uncommonNeighbor) const;
-    uint32_t getNextNodeWithIdenticalNeighbors(const uint32_t &previousNode, const std::vector<uint32_t> &neighbors) const;
     void replaceNeighbor(const uint32_t &node, const uint32_t &oldNeighbor, const uint32_t &newNeighbor);
     void print(bool direction) const;
     void printWithGraphTraversal(bool direction) const;
     void printEdgeCounts() const;
 
+    /* Undo trail, for searching on a single graph instead of one copy per search node.
+     * When enabled, every modification is recorded, and undo(mark) restores the graph
+     * to the state it had when getTrailMark() returned mark */
+    void enableTrail() {
+        trailEnabled = true;
+    }
+    size_t getTrailMark() const {
+        return trail.size();
+    }
+    void undo(const size_t &mark);
+
+    /* Append the position of every node whose degree, edges or removal changes to touchedNodes, until called with NULL */
+    void trackTouchedNodes(std::vector<uint32_t> *touchedNodes) {
+        this->touchedNodes = touchedNodes;
+    }
+
     /* Mark selected nodes as removed and reduce their neighbors' neighbor count.
      * fullComponent should be set to true when the nodes to be removed belong in the same component, and
      * that component has no other nodes (e.g. when removing line graphs). */
@@ -110,19 +144,20 @@ public:
     void remove(const Container &nodes, ReduceInfo &reduceInfo, const bool &fullComponent = false, std::unordered_set<uint32_t> *candidateNodes = NULL, const bool &removeZeroDegreeNodes = false) {
         for (auto it = nodes.begin() ; it != nodes.end() ; it++) {
             //std::cout << "removing " << *it << std::endl;
-            uint32_t pos = (!mapping ? *it : idToPos->at(*it));
+            uint32_t pos = (!mapping ? *it : (*idToPos)[*it]);
             if (!nodeIndex[pos].removed) {
                 reduceInfo.nodesRemoved++;
                 if (!fullComponent) {
-                    uint32_t nextNodeOffset = (pos == nodeIndex.size()-1 ? edgeBuffer->size() : nodeIndex[pos+1].offset);
+                    uint32_t nextNodeOffset = getSlotEnd(pos);
                     for (uint32_t offset = nodeIndex[pos].offset ; offset < nextNodeOffset ; offset++) {
                         uint32_t neighbor = (*edgeBuffer)[offset];
-                        uint32_t nPos = (!mapping ? neighbor : idToPos->at(neighbor));
+                        uint32_t nPos = (!mapping ? neighbor : (*idToPos)[neighbor]);
                         if (!nodeIndex[nPos].removed) {
-                            nodeIndex[nPos].edges--;
+                            recordNodeInfo(nPos);
+                            setEdges(nPos, nodeIndex[nPos].edges - 1);
                             if (removeZeroDegreeNodes && !nodeIndex[nPos].edges) {
-                                zeroDegreeNodes.push_back(neighbor);
-                                nodeIndex[nPos].removed = true;
+                                pushZeroDegreeNode(neighbor);
+                                setRemoved(nPos);
                             }
                             if (find(std::next(it, 1), nodes.end(), neighbor) == nodes.end() &&
                             candidateNodes != NULL && (nodeIndex[nPos].edges == 2 || nodeIndex[nPos].edges == 3) && nPos < pos) {
@@ -132,18 +167,19 @@ public:
                     }
                 }
                 //nodeIndex[pos].edges = 0;
-                nodeIndex[pos].removed = true;
+                recordNodeInfo(pos);
+                setRemoved(pos);
             }
         }
     }
 
     template <typename Container, typename OriginalNodesContainer = std::unordered_set<uint32_t> >
     bool gatherNeighbors(const uint32_t &node, Container &neighbors, const OriginalNodesContainer *nodes = NULL, const uint32_t &maxNeighbors = NONE) const {
-        uint32_t pos = (!mapping ? node : idToPos->at(node));
+        uint32_t pos = (!mapping ? node : (*idToPos)[node]);
         uint32_t neighborCount = nodeIndex[pos].edges;
-        uint32_t nextNodeOffset = (pos == nodeIndex.size()-1 ? edgeBuffer->size() : nodeIndex[pos+1].offset);
+        uint32_t nextNodeOffset = getSlotEnd(pos);
         for (uint32_t offset = nodeIndex[pos].offset ; offset < nextNodeOffset && neighborCount; offset++) {
-            uint32_t nPos = (!mapping ? (*edgeBuffer)[offset] : idToPos->at((*edgeBuffer)[offset]));
+            uint32_t nPos = (!mapping ? (*edgeBuffer)[offset] : (*idToPos)[(*edgeBuffer)[offset]]);
             if (!nodeIndex[nPos].removed && (nodes == NULL || nodes->find((*edgeBuffer)[offset]) == nodes->end())) {
                 neighbors.insert(neighbors.end(), (*edgeBuffer)[offset]);
                 if (maxNeighbors != NONE && neighbors.size() > maxNeighbors) {
@@ -157,16 +193,17 @@ public:
 
     template <typename Container, typename ContainerRemoved = std::vector<uint32_t> >
     bool gatherNeighborsWithRemoved(const uint32_t &node, Container &neighbors, ContainerRemoved &removedNeighbors) const {
-        uint32_t pos = (!mapping ? node : idToPos->at(node));
-        uint32_t nextNodeOffset = (pos == nodeIndex.size()-1 ? edgeBuffer->size() : nodeIndex[pos+1].offset);
+        uint32_t pos = (!mapping ? node : (*idToPos)[node]);
+        uint32_t nextNodeOffset = getSlotEnd(pos);
         for (uint32_t offset = nodeIndex[pos].offset ; offset < nextNodeOffset ; offset++) {
-            uint32_t nPos = (!mapping ? (*edgeBuffer)[offset] : idToPos->at((*edgeBuffer)[offset]));
+            uint32_t nPos = (!mapping ? (*edgeBuffer)[offset] : (*idToPos)[(*edgeBuffer)[offset]]);
             if (!nodeIndex[nPos].removed) {
                 neighbors.insert(neighbors.end(), (*edgeBuffer)[offset]);
             } else {
                 removedNeighbors.insert(removedNeighbors.end(), (*edgeBuffer)[offset]);
             }
         }
+        return true;
     }
 
     template <typename Container, typename OriginalNodesContainer>
@@ -191,6 +228,12 @@ public:
         return count;
     }
 
+    /* End of the slot of neighbors of a position in edgeBuffer. Slots are laid out in position order when the graph is
+     * built, but a slot that addEdges outgrows moves to the end of edgeBuffer until the next rebuild */
+    uint32_t getSlotEnd(const uint32_t &pos) const {
+        return nodeIndex[pos].offset + nodeIndex[pos].capacity;
+    }
+
     bool edgeExists(const uint32_t &node, const uint32_t &neighbor) const {
         return (findEdgeOffset(node, neighbor) != NONE);
     }
@@ -198,11 +241,11 @@ public:
     /* Check whether a particular edge exists with binary search,
      * return neighbor's offset in edge buffer */
     uint32_t findEdgeOffset(const uint32_t &node, const uint32_t &neighbor) const {
-        uint32_t pos = (!mapping ? node : idToPos->at(node));
-        uint32_t nPos = (!mapping ? neighbor : idToPos->at(neighbor));
+        uint32_t pos = (!mapping ? node : (*idToPos)[node]);
+        uint32_t nPos = (!mapping ? neighbor : (*idToPos)[neighbor]);
         assert(!nodeIndex[pos].removed && !nodeIndex[nPos].removed);
         uint32_t offset = nodeIndex[pos].offset;
-        uint32_t endOffset = (pos == nodeIndex.size()-1 ? edgeBuffer->size() - 1 : nodeIndex[pos+1].offset - 1);
+        uint32_t endOffset = getSlotEnd(pos) - 1;
         if (offset == endOffset+1) {
             return NONE;
         }
@@ -275,6 +318,30 @@ public:
         uint32_t curEdgeOffset;
     };
 
+    /* Blocks (biconnected components) of the graph. Each block has a top node, through which it hangs from the block
+     * above it in the depth first search, unless the top is the root. Nodes in more than one block are articulation points,
+     * and removing one leaves as many components as its blocks. Blocks are in postorder, after all blocks below them */
+    struct BlockCutTree {
+    public:
+        uint32_t getBlocks() const {
+            return blockTop.size();
+        }
+        uint32_t getBlockSize(const uint32_t &block) const {
+            return blockOffset[block + 1] - blockOffset[block];
+        }
+
+        std::vector<uint32_t> preorder; // Ids in depth first search order
+        std::vector<uint32_t> blockOffset; // Block i has the nodes blockNodes[blockOffset[i]] to blockNodes[blockOffset[i+1]-1]
+        std::vector<uint32_t> blockNodes; // Ids, top node first
+        std::vector<uint32_t> blockTop;
+        std::vector<uint32_t> blockDegreeSum; // Degrees of the nodes of a block, in the whole graph
+        /* The nodes below the top of block i, in this and lower blocks, are preorder[subtreeBegin[i]] onwards,
+         * subtreeSize[i] of them */
+        std::vector<uint32_t> subtreeBegin;
+        std::vector<uint32_t> subtreeSize;
+        bool connected; // Whether the nodes with edges form a single component
+    };
+
     /* Return the next node in a graph traversal, ignoring removed or zero-degree ones.
      * Initialise its first edge in the traversal as its first non-removed neighbor. */
     void getNextNode(GraphTraversal &graphTraversal) const {
@@ -283,7 +350,7 @@ public:
         if (graphTraversal.curNode == NONE) {
             pos = NONE;
         } else {
-            pos = (!mapping ? graphTraversal.curNode : idToPos->at(graphTraversal.curNode));
+            pos = (!mapping ? graphTraversal.curNode : (*idToPos)[graphTraversal.curNode]);
         }
         while (firstTime || pos == NONE || !nodeIndex[pos].edges) {
             if (pos == NONE && nodeIndex.size() || pos != NONE && pos < nodeIndex.size() - 1) {
@@ -308,12 +375,12 @@ public:
     /* Return next edge in a graph traversal, ignoring removed nodes */
     void getNextEdge(GraphTraversal &graphTraversal) const {
         assert(graphTraversal.curNode != NONE && graphTraversal.curEdgeOffset != NONE);
-        uint32_t pos = (!mapping ? graphTraversal.curNode : idToPos->at(graphTraversal.curNode));
-        uint32_t nextNodeOffset = (pos == nodeIndex.size()-1 ? edgeBuffer->size() : nodeIndex[pos+1].offset);
+        uint32_t pos = (!mapping ? graphTraversal.curNode : (*idToPos)[graphTraversal.curNode]);
+        uint32_t nextNodeOffset = getSlotEnd(pos);
         graphTraversal.curEdgeOffset++;
         bool validNeighbor = false;
         for ( ; graphTraversal.curEdgeOffset  < nextNodeOffset ; graphTraversal.curEdgeOffset++) {
-            uint32_t nPos = (!mapping ? (*edgeBuffer)[graphTraversal.curEdgeOffset] : idToPos->at((*edgeBuffer)[graphTraversal.curEdgeOffset]));
+            uint32_t nPos = (!mapping ? (*edgeBuffer)[graphTraversal.curEdgeOffset] : (*idToPos)[(*edgeBuffer)[graphTraversal.curEdgeOffset]]);
             if (!nodeIndex[nPos].removed) {
                 validNeighbor = true;
                 break;
@@ -327,7 +394,7 @@ public:
     /* Jump to a node */
     void goToNode(const uint32_t &node, GraphTraversal &graphTraversal) const {
         graphTraversal.curNode = node;
-        uint32_t pos = (!mapping ? node : idToPos->at(node));
+        uint32_t pos = (!mapping ? node : (*idToPos)[node]);
         graphTraversal.curEdgeOffset = getFirstValidNeighborOffset(pos);
     }
 
@@ -377,8 +444,66 @@ public:
 private:
     struct Funnel;
 
-    void static parseNodeIDs(char *buf, uint32_t *sourceNode, uint32_t *targetNode);
-    void fill(const uint32_t &size, const bool &checkIndependentSet);
+    /* Header of the binary graph format of writeBinary() */
+    struct BinaryHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t nodes;
+        uint32_t reserved;
+        uint64_t edges; // Entries of the edge buffer, twice the number of edges
+    };
+
+    /* Smallest piece of an edge list parsed by a thread */
+    static const size_t MIN_CHUNK = 1 << 22;
+
+    /* Dense renumbering of the ids that occur in the input, in the same order. The ids are marked on a bitmap, along with
+     * the number of marked ids before each word of it, so that the dense id of an id is a lookup and a popcount */
+    struct IdCompaction {
+    public:
+        void mark(const uint32_t &id) {
+            if ((id >> 6) >= words.size()) {
+                words.resize((id >> 6) + 1, 0);
+            }
+            words[id >> 6] |= 1ULL << (id & 63);
+        }
+        /* Count the ids before each word, and return the number of ids */
+        uint32_t finish() {
+            ranks.resize(words.size());
+            uint32_t ids = 0;
+            for (uint32_t i = 0 ; i < words.size() ; i++) {
+                ranks[i] = ids;
+                ids += __builtin_popcountll(words[i]);
+            }
+            return ids;
+        }
+        uint32_t getDenseId(const uint32_t &id) const {
+            return ranks[id >> 6] + __builtin_popcountll(words[id >> 6] & ((1ULL << (id & 63)) - 1));
+        }
+        /* The original id of each dense id */
+        void getIds(std::vector<uint32_t> &ids) const {
+            for (uint32_t i = 0 ; i < words.size() ; i++) {
+                for (uint64_t word = words[i] ; word ; word &= word - 1) {
+                    ids.push_back((i << 6) + __builtin_ctzll(word));
+                }
+            }
+        }
+
+    private:
+        std::vector<uint64_t> words;
+        std::vector<uint32_t> ranks;
+    };
+
+    void readEdgeList(const char *file, const char *end, const std::string &inputFile, const uint64_t &loadMemory, IdCompaction *compaction);
+    uint32_t parseSegment(const char *begin, const char *end, const uint64_t &reserveEdges, std::vector<std::vector<uint32_t> > &chunkEdges);
+    void buildFromEdges(std::vector<std::vector<uint32_t> > &chunkEdges, const uint32_t &nodes);
+    void mergeRuns(std::vector<FILE *> &runs, const uint32_t &nodes, const IdCompaction *compaction);
+    void readBinary(const char *file, const size_t &fileSize, const std::string &inputFile);
+    void compactNodes(IdCompaction &compaction);
+    void relabel(std::vector<uint32_t> &inputIds);
+    static uint32_t parseEdges(const char *begin, const char *end, std::vector<uint32_t> &edges);
+    void detachEdgeBuffer();
+    void detachMappers();
+    void recordSnapshot();
     bool getFunnels(std::vector<Funnel> &funnels, const uint32_t *measure = NULL, uint32_t *effectiveNode = NULL, Funnel *fourFunnel = NULL) const;
     uint32_t getGoodNode(std::vector<Traversal *> &frontier, std::unordered_set<uint32_t> &set, std::vector<uint32_t> &nodes, const uint32_t &size) const;
     uint32_t getOptimalDegree4Node1() const;
@@ -386,29 +511,169 @@ private:
     void getOptimalDegree4Node3(uint32_t &maxNodeWithCond, uint32_t &maxNode) const;
     bool checkSeparation(const std::unordered_set<uint32_t> &cut, std::vector<uint32_t> &component1, std::vector<uint32_t> &component2, bool &actualComponent1) const;
     bool buildCC(const std::unordered_set<uint32_t> &excludedNodes, std::vector<uint32_t> &component1, std::vector<uint32_t> &component2) const;
-    void static addPalmTreeArc(std::unordered_map<uint32_t, std::vector<uint32_t> > &palmTree, const uint32_t &node, const uint32_t &neighbor);
-    struct Value1 {
-        Value1(const uint32_t &visit) : visit(visit), low1(NONE), low2(visit), nd(0) {}
-        uint32_t visit;
-        uint32_t low1;
-        uint32_t low2;
-        uint32_t nd;
-    };
-    bool getSeparatingPairs2(std::unordered_set<uint32_t> &vertexCut, std::vector<uint32_t> &component1, std::vector<uint32_t> &component2, bool &actualComponent1,
-                               const uint32_t &numberOfNodes, std::unordered_map<uint32_t, std::vector<uint32_t> > &palmTree1, std::unordered_map<uint32_t, std::vector<uint32_t> > &palmTree2,
-                               std::unordered_map<uint32_t, std::vector<uint32_t> > &bothPalmTrees, std::unordered_map<uint32_t, Value1> &oldExploredSet, std::unordered_map<uint32_t, uint32_t> &fathers, std::unordered_map<uint32_t, uint32_t> &sons, std::unordered_map<uint32_t, std::unordered_set<uint32_t> > &descendants, std::unordered_map<uint32_t, uint32_t> &visitToId) const;
-
-
 
     struct NodeInfo {
     public:
-        NodeInfo(const uint32_t &offset, const uint32_t &edges) : offset(offset), edges(edges), removed(false) {}
+        NodeInfo(const uint32_t &offset, const uint32_t &edges) : offset(offset), edges(edges), capacity(edges), removed(false) {}
 
         uint32_t offset; // Offset of neighbors in edgeBuffer
         uint32_t edges;
+        uint32_t capacity; // Length of the slot of neighbors in edgeBuffer, which also holds removed neighbors
         bool removed;
     };
 
+    /* A single modification in the undo trail. Depending on the type, pos is a nodeIndex position,
+     * an edgeBuffer offset or a snapshot index, and value is the old edge or an element count */
+    struct TrailEntry {
+        enum class Type {
+            NODE_INFO, EDGE, EDGE_INSERTION, ZERO_DEGREE_NODE, NEW_NODE, SNAPSHOT
+        };
+
+        TrailEntry(const Type &type, const uint32_t &pos, const uint32_t &value, const NodeInfo &nodeInfo = NodeInfo(0, 0)) : type(type), pos(pos), value(value), nodeInfo(nodeInfo) {}
+
+        Type type;
+        uint32_t pos;
+        uint32_t value;
+        NodeInfo nodeInfo;
+    };
+
+    /* Whole graph state before a rebuild, which replaces all structures at once */
+    struct Snapshot {
+        std::vector<NodeInfo> nodeIndex;
+        std::shared_ptr<std::vector<uint32_t> > edgeBuffer;
+        std::vector<uint32_t> zeroDegreeNodes;
+        bool mapping;
+        std::shared_ptr<std::vector<uint32_t> > idToPos;
+        std::shared_ptr<std::vector<uint32_t> > posToId;
+    };
+
+    /* Nodes that are not removed, in a doubly linked list for each degree (a bucket queue), kept up to date
+     * along with nodeIndex. Degree queries take time proportional to the degree or to the answer */
+    struct DegreeBuckets {
+    public:
+        DegreeBuckets() : maxDegree(0), nodes(0), totalEdges(0) {}
+
+        std::vector<uint32_t> next; // By position, NONE at the end of a bucket
+        std::vector<uint32_t> previous;
+        std::vector<uint32_t> head; // By degree
+        std::vector<uint32_t> size;
+        uint32_t maxDegree; // Buckets of larger degrees are empty
+        uint32_t nodes;
+        uint32_t totalEdges; // Sum of degrees
+    };
+
+    void insertIntoBucket(const uint32_t &pos) {
+        DegreeBuckets &b = degreeBuckets;
+        uint32_t degree = nodeIndex[pos].edges;
+        if (degree >= b.head.size()) {
+            b.head.resize(degree + 1, NONE);
+            b.size.resize(degree + 1, 0);
+        }
+        b.previous[pos] = NONE;
+        b.next[pos] = b.head[degree];
+        if (b.head[degree] != NONE) {
+            b.previous[b.head[degree]] = pos;
+        }
+        b.head[degree] = pos;
+        b.size[degree]++;
+        b.nodes++;
+        b.totalEdges += degree;
+        if (degree > b.maxDegree) {
+            b.maxDegree = degree;
+        }
+    }
+
+    void eraseFromBucket(const uint32_t &pos) {
+        DegreeBuckets &b = degreeBuckets;
+        uint32_t degree = nodeIndex[pos].edges;
+        if (b.previous[pos] == NONE) {
+            b.head[degree] = b.next[pos];
+        } else {
+            b.next[b.previous[pos]] = b.next[pos];
+        }
+        if (b.next[pos] != NONE) {
+            b.previous[b.next[pos]] = b.previous[pos];
+        }
+        b.size[degree]--;
+        b.nodes--;
+        b.totalEdges -= degree;
+        while (b.maxDegree && !b.size[b.maxDegree]) {
+            b.maxDegree--;
+        }
+    }
+
+    /* Modifications of nodeIndex entries, which also move them between buckets */
+    void setNodeInfo(const uint32_t &pos, const NodeInfo &nodeInfo) {
+        touch(pos);
+        if (!nodeIndex[pos].removed) {
+            eraseFromBucket(pos);
+        }
+        nodeIndex[pos] = nodeInfo;
+        if (!nodeInfo.removed) {
+            insertIntoBucket(pos);
+        }
+    }
+
+    void setEdges(const uint32_t &pos, const uint32_t &edges) {
+        NodeInfo nodeInfo = nodeIndex[pos];
+        nodeInfo.edges = edges;
+        setNodeInfo(pos, nodeInfo);
+    }
+
+    void setRemoved(const uint32_t &pos) {
+        touch(pos);
+        if (!nodeIndex[pos].removed) {
+            eraseFromBucket(pos);
+            nodeIndex[pos].removed = true;
+        }
+    }
+
+    void pushNodeInfo(const NodeInfo &nodeInfo) {
+        touch(nodeIndex.size());
+        nodeIndex.push_back(nodeInfo);
+        degreeBuckets.next.push_back(NONE);
+        degreeBuckets.previous.push_back(NONE);
+        if (!nodeInfo.removed) {
+            insertIntoBucket(nodeIndex.size() - 1);
+        }
+    }
+
+    void popNodeInfo() {
+        if (!nodeIndex.back().removed) {
+            eraseFromBucket(nodeIndex.size() - 1);
+        }
+        nodeIndex.pop_back();
+        degreeBuckets.next.pop_back();
+        degreeBuckets.previous.pop_back();
+    }
+
+    void buildDegreeBuckets();
+
+    void touch(const uint32_t &pos) {
+        if (touchedNodes != NULL) {
+            touchedNodes->push_back(pos);
+        }
+    }
+
+    void recordNodeInfo(const uint32_t &pos) {
+        if (trailEnabled) {
+            trail.push_back(TrailEntry(TrailEntry::Type::NODE_INFO, pos, 0, nodeIndex[pos]));
+        }
+    }
+
+    void recordEdge(const uint32_t &offset) {
+        if (trailEnabled) {
+            trail.push_back(TrailEntry(TrailEntry::Type::EDGE, offset, (*edgeBuffer)[offset]));
+        }
+    }
+
+    void pushZeroDegreeNode(const uint32_t &node) {
+        if (trailEnabled) {
+            trail.push_back(TrailEntry(TrailEntry::Type::ZERO_DEGREE_NODE, 0, 0));
+        }
+        zeroDegreeNodes.push_back(node);
+    }
+
     struct Traversal {
         Traversal(const uint32_t &node, const Graph &graph, Traversal *previous = NULL) {
             sourceNode = node;
@@ -461,9 +726,9 @@ private:
     uint32_t getFirstValidNeighborOffset(const uint32_t &pos) const {
         bool validNeighbor = false;
         uint32_t offset = nodeIndex[pos].offset;
-        uint32_t nextNodeOffset = (pos == nodeIndex.size()-1 ? edgeBuffer->size() : nodeIndex[pos+1].offset);
+        uint32_t nextNodeOffset = getSlotEnd(pos);
         for ( ; offset < nextNodeOffset ; offset++) {
-            uint32_t nPos = (!mapping ? (*edgeBuffer)[offset] : idToPos->at((*edgeBuffer)[offset]));
+            uint32_t nPos = (!mapping ? (*edgeBuffer)[offset] : (*idToPos)[(*edgeBuffer)[offset]]);
             if (!nodeIndex[nPos].removed) {
                 validNeighbor = true;
                 break;
@@ -473,14 +738,24 @@ private:
     }
 
     std::vector<NodeInfo> nodeIndex;
-    std::vector<uint32_t> *edgeBuffer; // Pointer to avoid copying at Graph::rebuild
+    DegreeBuckets degreeBuckets;
+    std::shared_ptr<std::vector<uint32_t> > edgeBuffer; // Shared between graph copies, until one of them modifies it
     std::vector<uint32_t> zeroDegreeNodes;
     uint32_t nextUnusedId;
 
-    /* Optional mappers, when ids are not equal to the equivalent vector index position */
+    /* Optional mappers, when ids are not equal to the equivalent vector index position.
+     * idToPos is indexed by id, with NONE for ids that are not in nodeIndex, so that finding the position
+     * of a neighbor is an array access rather than a hash lookup. Shared between graph copies like edgeBuffer */
     bool mapping;
-    std::unordered_map<uint32_t, uint32_t> *idToPos;
-    std::vector<uint32_t> *posToId;
+    std::shared_ptr<std::vector<uint32_t> > idToPos;
+    std::shared_ptr<std::vector<uint32_t> > posToId;
+
+    /* Undo trail, not shared between graph copies */
+    bool trailEnabled;
+    std::vector<TrailEntry> trail;
+    std::vector<Snapshot> snapshots;
+
+    std::vector<uint32_t> *touchedNodes; // Positions of modified nodes, while Reductions tracks them
 };
 
 #endif
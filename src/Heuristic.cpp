@@ -0,0 +1,182 @@
+#include <queue>
+#include <functional>
+#include "Heuristic.hpp"
+#include "Reductions.hpp"
+
+using namespace std;
+
+/* Run the reductions on a copy of the graph, take a greedy mis of the reduced graph and unfold it.
+ * Then improve it with (1,2)-swaps on the original graph, like the local search of Andrade, Resende
+ * and Werneck. If the unfolded set is not valid, fall back to a greedy mis of the original graph */
+void Heuristic::run(vector<uint32_t> &independentSet) const {
+    Graph reducedGraph(graph);
+    Mis mis;
+    Reductions reductions(reducedGraph, mis);
+    reductions.run(theta);
+    getGreedyMis(reducedGraph, mis.getMis());
+    vector<uint32_t> zeroDegreeNodes(reducedGraph.zeroDegreeNodes);
+    mis.unfoldHypernodes(zeroDegreeNodes, independentSet);
+    if (!isIndependentSet(independentSet)) {
+        independentSet.clear();
+        Graph originalGraph(graph);
+        getGreedyMis(originalGraph, independentSet);
+        independentSet.insert(independentSet.end(), originalGraph.zeroDegreeNodes.begin(), originalGraph.zeroDegreeNodes.end());
+    }
+    improveWithSwaps(independentSet);
+}
+
+/* Repeatedly add a node of minimum degree to the mis and remove it along with its neighbors.
+ * Degrees change on the fly, so outdated entries of the queue are skipped */
+void Heuristic::getGreedyMis(Graph &graph, vector<uint32_t> &mis) {
+    priority_queue<pair<uint32_t, uint32_t>, vector<pair<uint32_t, uint32_t> >, greater<pair<uint32_t, uint32_t> > > queue;
+    for (uint32_t pos = 0 ; pos < graph.nodeIndex.size() ; pos++) {
+        if (!graph.nodeIndex[pos].removed) {
+            queue.push({graph.nodeIndex[pos].edges, graph.getNode(pos)});
+        }
+    }
+    ReduceInfo reduceInfo;
+    vector<uint32_t> neighbors;
+    vector<uint32_t> secondNeighbors;
+    while (!queue.empty()) {
+        uint32_t degree = queue.top().first;
+        uint32_t node = queue.top().second;
+        queue.pop();
+        uint32_t pos = graph.getPos(node);
+        if (graph.nodeIndex[pos].removed || graph.nodeIndex[pos].edges != degree) {
+            continue;
+        }
+        mis.push_back(node);
+        neighbors.clear();
+        graph.gatherNeighbors(node, neighbors);
+        neighbors.push_back(node);
+        graph.remove(neighbors, reduceInfo);
+        neighbors.pop_back();
+        for (auto neighbor: neighbors) {
+            secondNeighbors.clear();
+            graph.gatherNeighbors(neighbor, secondNeighbors);
+            for (auto secondNeighbor: secondNeighbors) {
+                queue.push({graph.getNodeDegree(secondNeighbor), secondNeighbor});
+            }
+        }
+    }
+}
+
+/* Check in linear time, for sets that can be too large for Graph::isIndependentSet */
+bool Heuristic::isIndependentSet(const vector<uint32_t> &independentSet) const {
+    assert(!graph.mapping);
+    vector<bool> inSet(graph.nodeIndex.size(), false);
+    for (auto node: independentSet) {
+        if (node >= inSet.size() || inSet[node]) {
+            return false;
+        }
+        inSet[node] = true;
+    }
+    for (auto node: independentSet) {
+        uint32_t nextNodeOffset = graph.getSlotEnd(node);
+        for (uint32_t offset = graph.nodeIndex[node].offset ; offset < nextNodeOffset ; offset++) {
+            if (inSet[(*graph.edgeBuffer)[offset]]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* A (1,2)-swap removes a node x from the set and inserts two non adjacent neighbors of x, whose only
+ * neighbor in the set is x (their tightness is 1). Nodes left with tightness 0 are inserted as well.
+ * Every swap enlarges the set, so the search ends at a local optimum */
+void Heuristic::improveWithSwaps(vector<uint32_t> &independentSet) const {
+    uint32_t nodes = graph.nodeIndex.size();
+    vector<bool> inSet(nodes, false);
+    vector<uint32_t> tightness(nodes, 0);
+    vector<bool> queued(nodes, false);
+    vector<uint32_t> worklist;
+    auto begin = [&](const uint32_t &node) {
+        return graph.nodeIndex[node].offset;
+    };
+    auto end = [&](const uint32_t &node) {
+        return graph.getSlotEnd(node);
+    };
+    auto push = [&](const uint32_t &node) {
+        if (!queued[node]) {
+            queued[node] = true;
+            worklist.push_back(node);
+        }
+    };
+    auto insert = [&](const uint32_t &node) {
+        inSet[node] = true;
+        for (uint32_t offset = begin(node) ; offset < end(node) ; offset++) {
+            tightness[(*graph.edgeBuffer)[offset]]++;
+        }
+        push(node);
+    };
+
+    for (auto node: independentSet) {
+        insert(node);
+    }
+    for (uint32_t node = 0 ; node < nodes ; node++) {
+        if (!inSet[node] && !tightness[node]) {
+            insert(node);
+        }
+    }
+
+    vector<uint32_t> candidates;
+    while (!worklist.empty()) {
+        uint32_t node = worklist.back();
+        worklist.pop_back();
+        queued[node] = false;
+        if (!inSet[node]) {
+            continue;
+        }
+        candidates.clear();
+        for (uint32_t offset = begin(node) ; offset < end(node) ; offset++) {
+            uint32_t neighbor = (*graph.edgeBuffer)[offset];
+            if (tightness[neighbor] == 1) {
+                candidates.push_back(neighbor);
+            }
+        }
+        uint32_t node1 = NONE, node2 = NONE;
+        for (uint32_t i = 0 ; i < candidates.size() && node1 == NONE ; i++) {
+            for (uint32_t j = i+1 ; j < candidates.size() ; j++) {
+                if (!graph.edgeExists(candidates[i], candidates[j])) {
+                    node1 = candidates[i];
+                    node2 = candidates[j];
+                    break;
+                }
+            }
+        }
+        if (node1 == NONE) {
+            continue;
+        }
+        inSet[node] = false;
+        for (uint32_t offset = begin(node) ; offset < end(node) ; offset++) {
+            tightness[(*graph.edgeBuffer)[offset]]--;
+        }
+        insert(node1);
+        insert(node2);
+        for (uint32_t offset = begin(node) ; offset < end(node) ; offset++) {
+            uint32_t neighbor = (*graph.edgeBuffer)[offset];
+            if (inSet[neighbor]) {
+                continue;
+            }
+            if (!tightness[neighbor]) {
+                insert(neighbor);
+            } else if (tightness[neighbor] == 1) {
+                /* Its only neighbor in the set may now have a swap */
+                for (uint32_t offset2 = begin(neighbor) ; offset2 < end(neighbor) ; offset2++) {
+                    if (inSet[(*graph.edgeBuffer)[offset2]]) {
+                        push((*graph.edgeBuffer)[offset2]);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    independentSet.clear();
+    for (uint32_t node = 0 ; node < nodes ; node++) {
+        if (inSet[node]) {
+            independentSet.push_back(node);
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef HEURISTIC_H
+#define HEURISTIC_H
+
+#include "Graph.hpp"
+#include "Mis.hpp"
+
+/* Fast, non exact independent set of a graph, to have a solution before the exact search
+ * and a lower bound for pruning it */
+class Heuristic {
+public:
+    Heuristic(const Graph &graph, const uint32_t &theta) : graph(graph), theta(theta) {}
+    void run(std::vector<uint32_t> &independentSet) const;
+
+private:
+    static void getGreedyMis(Graph &graph, std::vector<uint32_t> &mis);
+    bool isIndependentSet(const std::vector<uint32_t> &independentSet) const;
+    void improveWithSwaps(std::vector<uint32_t> &independentSet) const;
+
+    const Graph &graph; // Original graph, left intact
+    uint32_t theta;
+};
+
+#endif
@@ -3,6 +3,7 @@
 using namespace std;
 
 string Mis::misOutputFile = ".mis";
+vector<uint32_t> Mis::inputIds;
 
 /* Insert hypernode, mark any inner hypernodes' outerLevel as false */
 void Mis::markHypernode(const uint32_t &hypernode, const vector<uint32_t> &nodes, const vector<uint32_t> &neighbors) {
@@ -17,6 +18,7 @@ void Mis::markHypernode(const uint32_t &hypernode, const vector<uint32_t> &nodes
         container = &neighbors;
     }
     assert(hypernodeToInnernode.insert({hypernode, Innernode(nodes, neighbors)}).second);
+    extraNodes += nodes.size();
 }
 
 void Mis::unfoldHypernodes(vector<uint32_t> &zeroDegreeNodes, vector<uint32_t> &finalMis) {
@@ -26,9 +28,9 @@ void Mis::unfoldHypernodes(vector<uint32_t> &zeroDegreeNodes, vector<uint32_t> &
     expandExcludedNodes(finalMis);
 }
 
-void Mis::print(vector<uint32_t> &finalMis) {
-    cout <<"\nWriting Maximum Independent Set to file " << Mis::misOutputFile << endl;
-    cout << "Maximum Independent Set size: " << finalMis.size() << "\n";
+void Mis::print(vector<uint32_t> &finalMis, const string &description) {
+    cout <<"\nWriting " << description << " to file " << Mis::misOutputFile << endl;
+    cout << description << " size: " << finalMis.size() << "\n";
     FILE *f;
     f = fopen(Mis::misOutputFile.c_str(), "w");
     if (f == NULL) {
@@ -37,7 +39,7 @@ void Mis::print(vector<uint32_t> &finalMis) {
     }
     fprintf(f, "Maximum Independent Set size: %ld\n", finalMis.size());
     for (auto node : finalMis) {
-        fprintf(f, "%" PRIu32 "\n", node);
+        fprintf(f, "%" PRIu32 "\n", (inputIds.empty() ? node : inputIds[node]));
     }
     fclose(f);
 }
@@ -120,6 +122,38 @@ void Mis::removeHypernodes(const unordered_map<uint32_t, Innernode> &hypernodes)
     for (auto h: hypernodes) {
         hypernodeToInnernode.erase(h.first);
     }
+    recomputeExtraNodes();
+}
+
+/* Keep only the hypernodes among nodes and the ones nested in them, for solving the connected component
+ * of nodes separately. Subsequent nodes are all kept, as they are only added along with a node of the mis */
+void Mis::keepHypernodes(const vector<uint32_t> &nodes) {
+    unordered_map<uint32_t, Innernode> kept;
+    vector<uint32_t> frontier;
+    for (auto node: nodes) {
+        if (hypernodeToInnernode.find(node) != hypernodeToInnernode.end()) {
+            frontier.push_back(node);
+        }
+    }
+    while (!frontier.empty()) {
+        auto hypernode = hypernodeToInnernode.find(frontier.back());
+        frontier.pop_back();
+        if (!kept.insert(*hypernode).second) {
+            continue;
+        }
+        for (auto node: hypernode->second.nodes) {
+            if (hypernodeToInnernode.find(node) != hypernodeToInnernode.end()) {
+                frontier.push_back(node);
+            }
+        }
+        for (auto node: hypernode->second.neighbors) {
+            if (hypernodeToInnernode.find(node) != hypernodeToInnernode.end()) {
+                frontier.push_back(node);
+            }
+        }
+    }
+    hypernodeToInnernode.swap(kept);
+    recomputeExtraNodes();
 }
 
 void Mis::removeSubsequentNodes(unordered_set<uint32_t> &nodes) {
@@ -133,6 +167,22 @@ void Mis::removeSubsequentNodes(unordered_set<uint32_t> &nodes) {
     for (auto i: toRemove) {
         subsequentNodes.erase(i);
     }
+    recomputeExtraNodes();
+}
+
+/* After removing hypernodes or subsequent nodes, it is no longer known which reductions the remaining
+ * ones came from. Each hypernode still adds exactly its nodes, but each distinct subsequent node
+ * is counted as possibly added */
+void Mis::recomputeExtraNodes() {
+    extraNodes = 0;
+    for (auto &h: hypernodeToInnernode) {
+        extraNodes += h.second.nodes.size();
+    }
+    unordered_set<uint32_t> subsequent;
+    for (auto &s: subsequentNodes) {
+        subsequent.insert(s.second);
+    }
+    extraNodes += subsequent.size();
 }
 
 void Mis::printAll(vector<uint32_t> &zeroDegreeNodes) const {
@@ -20,12 +20,20 @@ public:
 
 class Mis {
 public:
+    Mis() : extraNodes(0) {}
     std::vector<uint32_t> &getMis() {
         return mis;
     }
     void setMisOutputFile(std::string misOutputFile) {
         Mis::misOutputFile = misOutputFile;
     }
+    /* Ids of the input for the nodes of a compacted or reordered graph, which the mis is written with */
+    void setInputIds(std::vector<uint32_t> &inputIds) {
+        Mis::inputIds.swap(inputIds);
+    }
+    static const std::vector<uint32_t> &getInputIds() {
+        return inputIds;
+    }
     void markHypernode(const uint32_t &hypernode, const std::vector<uint32_t> &nodes, const std::vector<uint32_t> &neighbors);
     void unfoldHypernodes(std::vector<uint32_t> &zeroDegreeNodes, std::vector<uint32_t> &finalMis);
     std::unordered_map<uint32_t, uint32_t> &getSubsequentNodes() {
@@ -34,10 +42,17 @@ public:
     std::unordered_map<uint32_t, Innernode> &getHypernodeToInnerNode() {
         return hypernodeToInnernode;
     }
+    const uint32_t &getExtraNodes() const {
+        return extraNodes;
+    }
+    void addExtraNodes(const uint32_t &nodes) {
+        extraNodes += nodes;
+    }
     void removeSubsequentNodes(std::unordered_set<uint32_t> &nodes);
     void removeHypernodes(std::unordered_set<uint32_t> &nodes);
     void removeHypernodes(const std::unordered_map<uint32_t, Innernode> &hypernodes);
-    void static print(std::vector<uint32_t> &finalMis);
+    void keepHypernodes(const std::vector<uint32_t> &nodes);
+    void static print(std::vector<uint32_t> &finalMis, const std::string &description = "Maximum Independent Set");
     void printAll(std::vector<uint32_t> &zeroDegreeNodes) const;
 
 private:
@@ -78,6 +93,7 @@ private:
     }
 
     void expandExcludedNodes(std::vector<uint32_t> &finalMis);
+    void recomputeExtraNodes();
 
     std::vector<uint32_t> mis;
     std::unordered_map<uint32_t, Innernode> hypernodeToInnernode;
@@ -85,6 +101,11 @@ private:
     /* Including one key node in the mis, results in including the mapped node as well,
      * These could be hypernodes, regular nodes, or mixed */
     std::unordered_map<uint32_t, uint32_t> subsequentNodes;
+
+    /* Upper bound of the nodes that unfolding hypernodes and subsequent nodes adds to the final mis,
+     * on top of the mis and the nodes that are still in the graph */
+    uint32_t extraNodes;
     static std::string misOutputFile;
+    static std::vector<uint32_t> inputIds;
 };
 #endif
@@ -10,10 +10,19 @@
 
 using namespace std;
 
+/* The rules are applied until none of them applies. Graph modifications are tracked meanwhile, so that
+ * after its first pass over the whole graph, each rule only checks the nodes close to a modification */
 void Reductions::run(const uint32_t &theta) {
     if (!graph.nodeIndex.size()) {
         return;
     }
+    touchedNodes.clear();
+    dominatedMark = NONE;
+    unconfinedMark = NONE;
+    shortFunnelMark = NONE;
+    deskMark = NONE;
+    signatureMark = NONE;
+    graph.trackTouchedNodes(&touchedNodes);
     switch(theta) {
         case 8:
         case 7:
@@ -32,6 +41,71 @@ void Reductions::run(const uint32_t &theta) {
         default:
             assert(false);
     }
+    graph.trackTouchedNodes(NULL);
+}
+
+/* Get the nodes that a rule has to check on its next pass: all of them on its first pass, otherwise the ones
+ * within distance 2 of a node touched since mark, in the order of their positions. Advance mark for the next pass */
+void Reductions::getDirtyNodes(uint32_t &mark, vector<uint32_t> &nodes) {
+    nodes.clear();
+    if (mark == NONE) {
+        for (uint32_t pos = 0 ; pos < graph.nodeIndex.size() ; pos++) {
+            if (!graph.nodeIndex[pos].removed && graph.nodeIndex[pos].edges) {
+                nodes.push_back(graph.getNode(pos));
+            }
+        }
+        mark = touchedNodes.size();
+        return;
+    }
+    if (mark == touchedNodes.size()) {
+        return;
+    }
+    /* Each node is added once, and the neighbors of each node are added once */
+    enum State : uint8_t {CLEAN, DIRTY, EXPANDED};
+    vector<State> state(graph.nodeIndex.size(), CLEAN);
+    vector<bool> seeded(graph.nodeIndex.size(), false);
+    vector<uint32_t> positions;
+    vector<uint32_t> neighbors;
+    auto add = [&](const uint32_t &pos) {
+        if (state[pos] == CLEAN) {
+            state[pos] = DIRTY;
+            positions.push_back(pos);
+        }
+    };
+    auto expand = [&](const uint32_t &pos) {
+        add(pos);
+        if (state[pos] == EXPANDED) {
+            return;
+        }
+        state[pos] = EXPANDED;
+        uint32_t nextNodeOffset = graph.getSlotEnd(pos);
+        for (uint32_t offset = graph.nodeIndex[pos].offset ; offset < nextNodeOffset ; offset++) {
+            uint32_t neighborPos = graph.getPos((*graph.edgeBuffer)[offset]);
+            if (!graph.nodeIndex[neighborPos].removed) {
+                add(neighborPos);
+            }
+        }
+    };
+    for (uint32_t i = mark ; i < touchedNodes.size() ; i++) {
+        uint32_t pos = touchedNodes[i];
+        if (seeded[pos] || graph.nodeIndex[pos].removed) {
+            continue;
+        }
+        seeded[pos] = true;
+        expand(pos);
+        neighbors.clear();
+        graph.gatherNeighbors(graph.getNode(pos), neighbors);
+        for (auto neighbor: neighbors) {
+            expand(graph.getPos(neighbor));
+        }
+    }
+    sort(positions.begin(), positions.end());
+    for (auto pos: positions) {
+        if (graph.nodeIndex[pos].edges) {
+            nodes.push_back(graph.getNode(pos));
+        }
+    }
+    mark = touchedNodes.size();
 }
 
 void Reductions::reduce6(const uint32_t &theta) {
@@ -121,91 +195,158 @@ bool Reductions::removeDominatedNodes(const uint32_t &theta) {
     return true;
 }
 
+/* A node dominates another one if its neighbors, other than that node, are a subset of the other one's, which is then removed.
+ * Dominated pairs share a neighbor unless they are adjacent, so the pairs of each dirty node are its nodes within distance 2 */
 bool Reductions::removeDominatedNodes2(const uint32_t &theta) {
-    for (uint32_t pos1 = 0 ; pos1 < graph.nodeIndex.size() ; pos1++) {
-        if (!graph.nodeIndex[pos1].edges || graph.nodeIndex[pos1].removed || theta == 3 && graph.nodeIndex[pos1].edges != 1) {
+    vector<uint32_t> nodes;
+    getDirtyNodes(dominatedMark, nodes);
+    vector<uint32_t> checkedBy(graph.nodeIndex.size(), NONE);
+    vector<uint32_t> neighbors;
+    vector<uint32_t> secondNeighbors;
+    for (auto node: nodes) {
+        if (!isInGraph(node)) {
             continue;
         }
-        for (uint32_t pos2 = pos1+1 ; pos2 < graph.nodeIndex.size() ; pos2++) {
-            if (graph.nodeIndex[pos2].removed || graph.nodeIndex[pos1].edges > graph.nodeIndex[pos2].edges) {
+        uint32_t pos = graph.getPos(node);
+        neighbors.clear();
+        graph.gatherNeighbors(node, neighbors);
+        for (auto neighbor: neighbors) {
+            checkedBy[graph.getPos(neighbor)] = pos;
+        }
+        for (auto neighbor: neighbors) {
+            if (!isInGraph(node)) {
+                break;
+            }
+            if (!isInGraph(neighbor)) {
                 continue;
             }
-            uint32_t node1 = graph.getNode(pos1);
-            vector<uint32_t> neighbors1;
-            uint32_t nextNodeOffset = (pos2 == graph.nodeIndex.size()-1 ? graph.edgeBuffer->size() : graph.nodeIndex[pos2+1].offset);
-            graph.gatherNeighbors(node1, neighbors1);
-            vector<uint32_t>::iterator begin = graph.edgeBuffer->begin();
-            vector<uint32_t>::iterator end = graph.edgeBuffer->begin();
-            std::advance(begin, graph.nodeIndex[pos2].offset);
-            std::advance(end, nextNodeOffset);
-            if (isSubsetOf(neighbors1, begin, end)) {
-                uint32_t node2 = graph.getNode(pos2);
-                //cout << "Dominated node " << node2 << "\n";
-                graph.remove(node2, reduceInfo, (theta == 3 ? true : false));
-                if (!graph.nodeIndex[pos1].edges) {
-                    break;
+            removeDominatedNode(pos, graph.getPos(neighbor), theta);
+            secondNeighbors.clear();
+            graph.gatherNeighbors(neighbor, secondNeighbors);
+            for (auto secondNeighbor: secondNeighbors) {
+                uint32_t secondPos = graph.getPos(secondNeighbor);
+                if (secondPos == pos || checkedBy[secondPos] == pos || !isInGraph(node)) {
+                    continue;
                 }
+                checkedBy[secondPos] = pos;
+                removeDominatedNode(pos, secondPos, theta);
             }
         }
     }
+    return true;
+}
+
+/* Remove whichever of the two nodes is dominated by the other one, if any. Only the one with fewer edges can dominate,
+ * unless both have the same neighbors, in which case either one does */
+void Reductions::removeDominatedNode(const uint32_t &pos1, const uint32_t &pos2, const uint32_t &theta) {
+    if (graph.nodeIndex[pos1].removed || graph.nodeIndex[pos2].removed) {
+        return;
+    }
+    bool firstDominates = graph.nodeIndex[pos1].edges <= graph.nodeIndex[pos2].edges;
+    uint32_t pos = (firstDominates ? pos1 : pos2);
+    uint32_t dominatedPos = (firstDominates ? pos2 : pos1);
+    if (!graph.nodeIndex[pos].edges || theta == 3 && graph.nodeIndex[pos].edges != 1) {
+        return;
+    }
+    if (isDominatedBy(dominatedPos, pos)) {
+        uint32_t node = graph.getNode(dominatedPos);
+        //cout << "Dominated node " << node << "\n";
+        graph.remove(node, reduceInfo, (theta == 3 ? true : false));
+    }
+}
+
+/* Check whether the neighbors of the node at pos, other than the one at dominatedPos, are all neighbors of the one at dominatedPos.
+ * Both edge ranges are sorted by id, so they are merged in a single pass. Removed entries of dominatedPos' range don't matter,
+ * since each neighbor of pos is in the graph */
+bool Reductions::isDominatedBy(const uint32_t &dominatedPos, const uint32_t &pos) const {
+    const vector<uint32_t> &edgeBuffer = *graph.edgeBuffer;
+    uint32_t dominatedNode = graph.getNode(dominatedPos);
+    uint32_t nextNodeOffset = graph.getSlotEnd(pos);
+    uint32_t dominatedOffset = graph.nodeIndex[dominatedPos].offset;
+    uint32_t dominatedEnd = graph.getSlotEnd(dominatedPos);
+    for (uint32_t offset = graph.nodeIndex[pos].offset ; offset < nextNodeOffset ; offset++) {
+        uint32_t neighbor = edgeBuffer[offset];
+        if (neighbor == dominatedNode || graph.nodeIndex[graph.getPos(neighbor)].removed) {
+            continue;
+        }
+        while (dominatedOffset < dominatedEnd && edgeBuffer[dominatedOffset] < neighbor) {
+            dominatedOffset++;
+        }
+        if (dominatedOffset == dominatedEnd || edgeBuffer[dominatedOffset] != neighbor) {
+            return false;
+        }
+    }
+    return true;
 }
 
+/* Check the nodes close to a modification since the previous pass, or all of them on the first one */
 bool Reductions::removeDesks() {
-    Graph::GraphTraversal graphTraversal(graph);
-    while (graphTraversal.curNode != NONE) {
-        bool valid = true;
-        if (graph.getNodeDegree(graphTraversal.curNode) >= 3) {
-            vector<uint32_t> neighbors;
-            graph.gatherNeighbors(graphTraversal.curNode, neighbors);
-            if (valid) {
-                uint32_t b, d;
-                for (uint32_t i = 0 ; i < neighbors.size() ; i++) {
-                    b = neighbors[i];
-                    if (graph.getNodeDegree(b) < 3) {
+    vector<uint32_t> nodes;
+    getDirtyNodes(deskMark, nodes);
+    bool reduced = false;
+    for (auto node: nodes) {
+        if (isInGraph(node) && removeDesk(node)) {
+            reduced = true;
+        }
+    }
+    return reduced;
+}
+
+/* Reduce a desk with node as one of its corners, if there is one */
+bool Reductions::removeDesk(const uint32_t &node) {
+    bool valid = true;
+    if (graph.getNodeDegree(node) >= 3) {
+        vector<uint32_t> neighbors;
+        graph.gatherNeighbors(node, neighbors);
+        if (valid) {
+            uint32_t b, d;
+            for (uint32_t i = 0 ; i < neighbors.size() ; i++) {
+                b = neighbors[i];
+                if (graph.getNodeDegree(b) < 3) {
+                    continue;
+                }
+                for (uint32_t j = i+1 ; j < neighbors.size() ; j++) {
+                    d = neighbors[j];
+                    if (graph.getNodeDegree(d) < 3) {
                         continue;
                     }
-                    for (uint32_t j = i+1 ; j < neighbors.size() ; j++) {
-                        d = neighbors[j];
-                        if (graph.getNodeDegree(d) < 3) {
+                    vector<uint32_t> commonNeighbors;
+                    graph.getCommonNeighbors(b, d, commonNeighbors);
+                    for (auto c: commonNeighbors) {
+                        if (c == node || graph.getNodeDegree(c) < 3) {
                             continue;
                         }
-                        vector<uint32_t> commonNeighbors;
-                        graph.getCommonNeighbors(b, d, commonNeighbors);
-                        for (auto c: commonNeighbors) {
-                            if (c == graphTraversal.curNode || graph.getNodeDegree(c) < 3) {
-                                continue;
-                            }
-                            if (!graph.edgeExists(graphTraversal.curNode, c) && !graph.edgeExists(b, d)) {
-                                set<uint32_t> neighborsAC;
-                                set<uint32_t> neighborsBD;
-                                graph.gatherNeighbors(graphTraversal.curNode, neighborsAC);
-                                graph.gatherNeighbors(c, neighborsAC);
-                                graph.gatherNeighbors(b, neighborsBD);
-                                graph.gatherNeighbors(d, neighborsBD);
-                                if (neighborsAC.size() <= 4 && neighborsBD.size() <= 4) {
-                                    for (auto n: neighborsAC) {
-                                        if (neighborsBD.find(n) != neighborsBD.end()) {
-                                            valid = false;
-                                            break;
-                                        }
+                        if (!graph.edgeExists(node, c) && !graph.edgeExists(b, d)) {
+                            set<uint32_t> neighborsAC;
+                            set<uint32_t> neighborsBD;
+                            graph.gatherNeighbors(node, neighborsAC);
+                            graph.gatherNeighbors(c, neighborsAC);
+                            graph.gatherNeighbors(b, neighborsBD);
+                            graph.gatherNeighbors(d, neighborsBD);
+                            if (neighborsAC.size() <= 4 && neighborsBD.size() <= 4) {
+                                for (auto n: neighborsAC) {
+                                    if (neighborsBD.find(n) != neighborsBD.end()) {
+                                        valid = false;
+                                        break;
+                                    }
+                                }
+                                if (valid) {
+                                    //cout << "reducing desk " << node << "-" << b << "-" << c << "-" << d << "\n";
+                                    graph.remove(neighborsAC, reduceInfo);
+                                    graph.remove(neighborsBD, reduceInfo);
+                                    std::unordered_map<uint32_t, uint32_t> &subsequentNodes = mis.getSubsequentNodes();
+                                    mis.addExtraNodes(2);
+                                    for (auto neighborAC: neighborsAC) {
+                                        subsequentNodes.insert({neighborAC, b});
+                                        subsequentNodes.insert({neighborAC, d});
+                                        graph.addEdges(neighborAC, vector<uint32_t>(neighborsBD.begin(), neighborsBD.end()));
                                     }
-                                    if (valid) {
-                                        //cout << "reducing desk " << graphTraversal.curNode << "-" << b << "-" << c << "-" << d << "\n";
-                                        graph.remove(neighborsAC, reduceInfo);
-                                        graph.remove(neighborsBD, reduceInfo);
-                                        std::unordered_map<uint32_t, uint32_t> &subsequentNodes = mis.getSubsequentNodes();
-                                        for (auto neighborAC: neighborsAC) {
-                                            subsequentNodes.insert({neighborAC, b});
-                                            subsequentNodes.insert({neighborAC, d});
-                                            graph.addEdges(neighborAC, vector<uint32_t>(neighborsBD.begin(), neighborsBD.end()));
-                                        }
-                                        for (auto neighborBD: neighborsBD) {
-                                            subsequentNodes.insert({neighborBD, graphTraversal.curNode});
-                                            subsequentNodes.insert({neighborBD, c});
-                                            graph.addEdges(neighborBD, vector<uint32_t>(neighborsAC.begin(), neighborsAC.end()));
-                                        }
-                                        return true;
+                                    for (auto neighborBD: neighborsBD) {
+                                        subsequentNodes.insert({neighborBD, node});
+                                        subsequentNodes.insert({neighborBD, c});
+                                        graph.addEdges(neighborBD, vector<uint32_t>(neighborsAC.begin(), neighborsAC.end()));
                                     }
+                                    return true;
                                 }
                             }
                         }
@@ -213,12 +354,13 @@ bool Reductions::removeDesks() {
                 }
             }
         }
-        graph.getNextNode(graphTraversal);
     }
     return false;
 }
 
 
+/* Check the nodes close to a modification since the previous pass, or all of them on the first one.
+ * The rule depends on the minimum degree of the whole graph, so all of them are checked again once it changes */
 bool Reductions::removeShortFunnels(const uint32_t &theta) {
     //cout << "\n**Performing short funnels reduction**" << endl;
     uint32_t minDegree = NONE;
@@ -226,129 +368,146 @@ bool Reductions::removeShortFunnels(const uint32_t &theta) {
     if (minDegree > 4) {
         return false;
     }
-    Graph::GraphTraversal graphTraversal(graph);
-    while (graphTraversal.curNode != NONE) {
-        uint32_t nodeV = graphTraversal.curNode;
-        if (graph.getNodeDegree(nodeV) == 3) {
-            //cout << "nodeV " << nodeV << endl;
-            vector<uint32_t> neighborsV;
-            graph.gatherNeighbors(nodeV, neighborsV);
-            for (uint32_t i = 0 ; i < 3 ; i++) {
-                uint32_t nodeA = neighborsV[i];
-                uint32_t nodeB, nodeC;
-                if (i == 0) {
-                    nodeB = neighborsV[1];
-                    nodeC = neighborsV[2];
-                } else if (i == 1) {
-                    nodeB = neighborsV[0];
-                    nodeC = neighborsV[2];
-                } else {
-                    nodeB = neighborsV[0];
-                    nodeC = neighborsV[1];
-                }
-                if ((theta == 5 && graph.getNodeDegree(nodeA) == minDegree || theta == 4 && graph.getNodeDegree(nodeA) <= 4 || theta == 3) && graph.edgeExists(nodeB, nodeC)) {
-                    bool shortFunnel = false;
-                    vector<uint32_t> neighborsA;
-                    graph.gatherNeighbors(nodeA, neighborsA);
-                    if (theta == 5 && minDegree == 3 || theta == 4) {
-                        uint32_t edges;
-                        if (theta == 5) {
-                            edges = 1;
-                        } else if (theta == 4) {
-                            edges = graph.getNodeDegree(nodeA) - 2;
+    if (minDegree != shortFunnelMinDegree) {
+        shortFunnelMark = NONE;
+    }
+    vector<uint32_t> nodes;
+    getDirtyNodes(shortFunnelMark, nodes);
+    bool reduced = false;
+    for (auto nodeV: nodes) {
+        if (isInGraph(nodeV) && removeShortFunnel(nodeV, theta, minDegree)) {
+            reduced = true;
+            graph.getMinDegree(minDegree);
+            if (minDegree > 4) {
+                break;
+            }
+        }
+    }
+    shortFunnelMinDegree = minDegree;
+    return reduced;
+}
+
+/* Reduce a short funnel with nodeV as its degree 3 node, if there is one */
+bool Reductions::removeShortFunnel(const uint32_t &nodeV, const uint32_t &theta, const uint32_t &minDegree) {
+    if (graph.getNodeDegree(nodeV) == 3) {
+        //cout << "nodeV " << nodeV << endl;
+        vector<uint32_t> neighborsV;
+        graph.gatherNeighbors(nodeV, neighborsV);
+        for (uint32_t i = 0 ; i < 3 ; i++) {
+            uint32_t nodeA = neighborsV[i];
+            uint32_t nodeB, nodeC;
+            if (i == 0) {
+                nodeB = neighborsV[1];
+                nodeC = neighborsV[2];
+            } else if (i == 1) {
+                nodeB = neighborsV[0];
+                nodeC = neighborsV[2];
+            } else {
+                nodeB = neighborsV[0];
+                nodeC = neighborsV[1];
+            }
+            if ((theta == 5 && graph.getNodeDegree(nodeA) == minDegree || theta == 4 && graph.getNodeDegree(nodeA) <= 4 || theta == 3) && graph.edgeExists(nodeB, nodeC)) {
+                bool shortFunnel = false;
+                vector<uint32_t> neighborsA;
+                graph.gatherNeighbors(nodeA, neighborsA);
+                if (theta == 5 && minDegree == 3 || theta == 4) {
+                    uint32_t edges;
+                    if (theta == 5) {
+                        edges = 1;
+                    } else if (theta == 4) {
+                        edges = graph.getNodeDegree(nodeA) - 2;
+                    }
+                    for (auto &neighbor: neighborsA) {
+                        if (neighbor == nodeV) {
+                            continue;
                         }
-                        for (auto &neighbor: neighborsA) {
-                            if (neighbor == nodeV) {
-                                continue;
+                        if (graph.edgeExists(neighbor, nodeB) || graph.edgeExists(neighbor, nodeC)) {
+                            if (--edges) {
+                                shortFunnel = true;
+                                break;
                             }
-                            if (graph.edgeExists(neighbor, nodeB) || graph.edgeExists(neighbor, nodeC)) {
-                                if (--edges) {
+                        }
+                    }
+                } else if (theta == 5 && minDegree == 4) {
+                    uint32_t countB = 0;
+                    uint32_t countC = 0;
+                    uint32_t *count;
+                    uint32_t target;
+                    for (auto &neighbor: neighborsA) {
+                        count = &countB;
+                        target = nodeB;
+                        for (uint32_t i = 0 ; i < 2 ; i++) {
+                            if (graph.edgeExists(neighbor, target)) {
+                                (*count)++;
+                                if ((*count) == 2) {
                                     shortFunnel = true;
                                     break;
                                 }
                             }
+                            count = &countC;
+                            target = nodeC;
                         }
-                    } else if (theta == 5 && minDegree == 4) {
-                        uint32_t countB = 0;
-                        uint32_t countC = 0;
-                        uint32_t *count;
-                        uint32_t target;
-                        for (auto &neighbor: neighborsA) {
-                            count = &countB;
-                            target = nodeB;
-                            for (uint32_t i = 0 ; i < 2 ; i++) {
-                                if (graph.edgeExists(neighbor, target)) {
-                                    (*count)++;
-                                    if ((*count) == 2) {
-                                        shortFunnel = true;
-                                        break;
-                                    }
-                                }
-                                count = &countC;
-                                target = nodeC;
+                        if (shortFunnel) {
+                            break;
+                        }
+                    }
+                } else if (theta == 3) {
+                    uint32_t count = 0;
+                    uint32_t atmost = graph.getNodeDegree(nodeA);
+                    shortFunnel = true;
+                    for (auto &neighbor: neighborsA) {
+                        if (neighbor == nodeV) {
+                            continue;
+                        }
+                        if (!graph.edgeExists(neighbor, nodeB)) {
+                            if (++count > atmost) {
+                                shortFunnel = false;
+                                break;
                             }
-                            if (shortFunnel) {
+                        }
+                        if (!graph.edgeExists(neighbor, nodeC)) {
+                            if (++count > atmost) {
+                                shortFunnel = false;
                                 break;
                             }
                         }
-                    } else if (theta == 3) {
-                        uint32_t count = 0;
-                        uint32_t atmost = graph.getNodeDegree(nodeA);
-                        shortFunnel = true;
+                    }
+                }
+                if (shortFunnel) {
+                    //cout << "short funnel " << nodeA << "-" << nodeV << "-{" << nodeB << "," << nodeC << "}" << endl;
+                    vector<uint32_t> container;
+                    container.push_back(nodeA);
+                    container.push_back(nodeV);
+                    graph.remove(container, reduceInfo);
+                    uint32_t target = nodeB;
+                    for (uint32_t i = 0 ; i < 2 ; i++) {
+                        container.clear();
                         for (auto &neighbor: neighborsA) {
-                            if (neighbor == nodeV) {
+                            if (neighbor == nodeV || neighbor == target) {
                                 continue;
                             }
-                            if (!graph.edgeExists(neighbor, nodeB)) {
-                                if (++count > atmost) {
-                                    shortFunnel = false;
-                                    break;
-                                }
-                            }
-                            if (!graph.edgeExists(neighbor, nodeC)) {
-                                if (++count > atmost) {
-                                    shortFunnel = false;
-                                    break;
-                                }
+                            if (!graph.edgeExists(neighbor, target)) {
+                                container.push_back(neighbor);
+                                graph.addEdges(neighbor, vector<uint32_t>(1, target));
                             }
                         }
+                        graph.addEdges(target, container);
+                        target = nodeC;
                     }
-                    if (shortFunnel) {
-                        //cout << "short funnel " << nodeA << "-" << nodeV << "-{" << nodeB << "," << nodeC << "}" << endl;
-                        vector<uint32_t> container;
-                        container.push_back(nodeA);
-                        container.push_back(nodeV);
-                        graph.remove(container, reduceInfo);
-                        uint32_t target = nodeB;
-                        for (uint32_t i = 0 ; i < 2 ; i++) {
-                            container.clear();
-                            for (auto &neighbor: neighborsA) {
-                                if (neighbor == nodeV) {
-                                    continue;
-                                }
-                                if (!graph.edgeExists(neighbor, target)) {
-                                    container.push_back(neighbor);
-                                    graph.addEdges(neighbor, vector<uint32_t>(1, target));
-                                }
-                            }
-                            graph.addEdges(target, container);
-                            target = nodeC;
-                        }
-                        auto &subsequentNodes = mis.getSubsequentNodes();
-                        for (auto &neighbor: neighborsA) {
-                            if (neighbor == nodeV) {
-                                continue;
-                            }
-                            subsequentNodes.insert({neighbor, nodeV});
+                    auto &subsequentNodes = mis.getSubsequentNodes();
+                    mis.addExtraNodes(1);
+                    for (auto &neighbor: neighborsA) {
+                        if (neighbor == nodeV) {
+                            continue;
                         }
-                        subsequentNodes.insert({nodeB, nodeA});
-                        subsequentNodes.insert({nodeC, nodeA});
-                        return true;
+                        subsequentNodes.insert({neighbor, nodeV});
                     }
+                    subsequentNodes.insert({nodeB, nodeA});
+                    subsequentNodes.insert({nodeC, nodeA});
+                    return true;
                 }
             }
         }
-        graph.getNextNode(graphTraversal);
     }
     return false;
 }
@@ -374,68 +533,59 @@ void Reductions::removeEasyInstances(const uint32_t &theta) {
     }
 }
 
-/* Find mis via brute force. For easy instances */
+/* Find mis via brute force. For easy instances, which have at most 32 nodes, so that
+ * sets of them are bitmasks of their indexes in cc and the search needs no allocations */
 void Reductions::findMis(const vector<uint32_t> &cc) {
-    vector<uint32_t> independentSet;
-    vector<uint32_t> maximumIndependentSet;
-    vector<uint32_t> frontier; // cc array indexes
-    vector<unordered_set<uint32_t> > removedNodes;
-    frontier.push_back(0);
-    removedNodes.push_back(unordered_set<uint32_t>());
-    while (frontier.size()) {
-        uint32_t node = cc[frontier.back()];
-        Graph::GraphTraversal graphTraversal(graph, node);
+    assert(cc.size() <= 32);
+    uint32_t adjacency[32];
+    for (uint32_t i = 0 ; i < cc.size() ; i++) {
+        adjacency[i] = 0;
+        Graph::GraphTraversal graphTraversal(graph, cc[i]);
         while (graphTraversal.curEdgeOffset != NONE) {
-            removedNodes.back().insert((*graph.edgeBuffer)[graphTraversal.curEdgeOffset]);
+            uint32_t j = std::find(cc.begin(), cc.end(), (*graph.edgeBuffer)[graphTraversal.curEdgeOffset]) - cc.begin();
+            assert(j < cc.size());
+            adjacency[i] |= 1U << j;
             graph.getNextEdge(graphTraversal);
         }
-        uint32_t newNode = NONE;
-        uint32_t newIndex;
-        bool found = false;
-        for (newIndex = frontier.back()+1 ; newIndex < cc.size() ; newIndex++) {
-            if (cc.size() - newIndex + frontier.size() <= maximumIndependentSet.size()) {
-                break;
-            }
-            newNode = cc[newIndex];
-            if (removedNodes.back().find(newNode) == removedNodes.back().end()) {
-                found = true;
-                break;
-            }
+    }
+    uint32_t maxSet = 0;
+    findMaxIndependentSet(adjacency, (cc.size() == 32 ? UINT32_MAX : (1U << cc.size()) - 1), 0, maxSet);
+    vector<uint32_t> &mis = this->mis.getMis();
+    for (uint32_t i = 0 ; i < cc.size() ; i++) {
+        if (maxSet & (1U << i)) {
+            mis.push_back(cc[i]);
         }
-        if (found) {
-            frontier.push_back(newIndex);
-            removedNodes.push_back(removedNodes.back());
-        } else {
-            if (frontier.size() > maximumIndependentSet.size()) {
-                maximumIndependentSet = frontier;
-            }
-            while (frontier.size()) {
-                newIndex = frontier.back() + 1;
-                frontier.pop_back();
-                removedNodes.pop_back();
-                found = false;
-                for (; newIndex < cc.size() ; newIndex++) {
-                    if (cc.size() - newIndex + frontier.size() <= maximumIndependentSet.size()) {
-                        break;
-                    }
-                    newNode = cc[newIndex];
-                    if (!removedNodes.size() || removedNodes.size() && removedNodes.back().find(newNode) == removedNodes.back().end()) {
-                        found = true;
-                        break;
-                    }
-                }
-                if (found) {
-                    frontier.push_back(newIndex);
-                    removedNodes.push_back((removedNodes.size() ? removedNodes.back() : unordered_set<uint32_t>()));
-                    break;
-                }
-            }
+    }
+}
+
+/* Extend set with nodes of candidates, keeping the largest independent set found in maxSet. A node with
+ * at most one neighbor among the candidates is always taken, otherwise one of maximum degree is branched on */
+void Reductions::findMaxIndependentSet(const uint32_t *adjacency, const uint32_t &candidates, const uint32_t &set, uint32_t &maxSet) {
+    if (!candidates) {
+        if (__builtin_popcount(set) > __builtin_popcount(maxSet)) {
+            maxSet = set;
         }
+        return;
     }
-    vector<uint32_t> &mis = this->mis.getMis();
-    for (auto &i: maximumIndependentSet) {
-        mis.push_back(cc[i]);
+    if (__builtin_popcount(set) + __builtin_popcount(candidates) <= __builtin_popcount(maxSet)) {
+        return;
+    }
+    uint32_t branchNode = 0;
+    uint32_t maxDegree = 0;
+    for (uint32_t remaining = candidates ; remaining ; remaining &= remaining - 1) {
+        uint32_t node = __builtin_ctz(remaining);
+        uint32_t degree = __builtin_popcount(adjacency[node] & candidates);
+        if (degree <= 1) {
+            findMaxIndependentSet(adjacency, candidates & ~adjacency[node] & ~(1U << node), set | (1U << node), maxSet);
+            return;
+        }
+        if (degree > maxDegree) {
+            branchNode = node;
+            maxDegree = degree;
+        }
     }
+    findMaxIndependentSet(adjacency, candidates & ~adjacency[branchNode] & ~(1U << branchNode), set | (1U << branchNode), maxSet);
+    findMaxIndependentSet(adjacency, candidates & ~(1U << branchNode), set, maxSet);
 }
 
 bool Reductions::foldCompleteKIndependentSets(const uint32_t &theta, unordered_set<uint32_t> **oldCandidateNodes, unordered_set<uint32_t> **newCandidateNodes, const bool &theta4) {
@@ -503,7 +653,7 @@ void Reductions::foldCompleteKIndependentSets2(const uint32_t &theta, const bool
                 graph.gatherNeighbors(node, neighbors);
                 uint32_t secondNode = NONE;
                 if (k == 2 || k == 3) {
-                    secondNode = graph.getNextNodeWithIdenticalNeighbors(node, neighbors);
+                    secondNode = getTwin(node, neighbors, NONE);
                     if (secondNode != NONE) {
                         nodes.push_back(secondNode);
                     }
@@ -516,10 +666,10 @@ void Reductions::foldCompleteKIndependentSets2(const uint32_t &theta, const bool
                     uint32_t degree = graph.getNodeDegree(node);
                     if (degree == 3) {
                         uint32_t uncommonNeighbor;
-                        thirdNode = graph.getNodeWithOneUncommonNeighbor(neighbors, uncommonNeighbor);
+                        thirdNode = getNearTwin(neighbors, uncommonNeighbor);
                         neighbors.push_back(uncommonNeighbor);
                     } else if (degree == 4) {
-                        thirdNode = graph.getNextNodeWithIdenticalNeighbors(secondNode, neighbors);
+                        thirdNode = getTwin(node, neighbors, secondNode);
                     } else {
                         assert(false);
                     }
@@ -551,16 +701,109 @@ void Reductions::foldCompleteKIndependentSets2(const uint32_t &theta, const bool
     }
 }
 
+/* Index the nodes of degree 3 and 4 by the signature of their neighbors, and each node of degree 4 also
+ * by the signature of every 3 of its neighbors. Only the nodes touched since the previous update are indexed again,
+ * since a node's neighbors only change along with its degree or through replaceNeighbor. Entries of nodes that
+ * changed since are left in place, and lookups check that a node still has the neighbors of its entry */
+void Reductions::updateSignatures() {
+    uint32_t begin = signatureMark;
+    if (signatureMark == NONE) {
+        twins.clear();
+        nearTwins.clear();
+        signatureOfPos.assign(graph.nodeIndex.size(), 0);
+        for (uint32_t pos = 0 ; pos < graph.nodeIndex.size() ; pos++) {
+            indexSignature(pos);
+        }
+        begin = touchedNodes.size();
+    }
+    signatureOfPos.resize(graph.nodeIndex.size(), 0);
+    for (uint32_t i = begin ; i < touchedNodes.size() ; i++) {
+        indexSignature(touchedNodes[i]);
+    }
+    signatureMark = touchedNodes.size();
+}
+
+void Reductions::indexSignature(const uint32_t &pos) {
+    if (graph.nodeIndex[pos].removed || graph.nodeIndex[pos].edges < 3 || graph.nodeIndex[pos].edges > 4) {
+        signatureOfPos[pos] = 0;
+        return;
+    }
+    vector<uint32_t> neighbors;
+    graph.gatherNeighbors(graph.getNode(pos), neighbors);
+    uint64_t signature = getSignature(neighbors);
+    if (signature == signatureOfPos[pos]) {
+        return;
+    }
+    signatureOfPos[pos] = signature;
+    twins.insert(make_pair(signature, pos));
+    if (neighbors.size() == 4) {
+        for (auto neighbor: neighbors) {
+            nearTwins.insert(make_pair(signature - getNodeHash(neighbor) - SIGNATURE_DEGREE, pos));
+        }
+    }
+}
+
+/* Get a node other than node and excluded with exactly the given neighbors, or NONE */
+uint32_t Reductions::getTwin(const uint32_t &node, const vector<uint32_t> &neighbors, const uint32_t &excluded) {
+    updateSignatures();
+    vector<uint32_t> twinNeighbors;
+    auto range = twins.equal_range(getSignature(neighbors));
+    for (auto it = range.first ; it != range.second ; it++) {
+        uint32_t pos = it->second;
+        if (graph.nodeIndex[pos].removed || graph.nodeIndex[pos].edges != neighbors.size()) {
+            continue;
+        }
+        uint32_t twin = graph.getNode(pos);
+        if (twin == node || twin == excluded) {
+            continue;
+        }
+        twinNeighbors.clear();
+        graph.gatherNeighbors(twin, twinNeighbors);
+        if (twinNeighbors == neighbors) {
+            return twin;
+        }
+    }
+    return NONE;
+}
+
+/* Get a node of degree 4 whose neighbors are the given 3 ones and uncommonNeighbor, or NONE */
+uint32_t Reductions::getNearTwin(const vector<uint32_t> &neighbors, uint32_t &uncommonNeighbor) {
+    updateSignatures();
+    uncommonNeighbor = NONE;
+    vector<uint32_t> twinNeighbors;
+    auto range = nearTwins.equal_range(getSignature(neighbors));
+    for (auto it = range.first ; it != range.second ; it++) {
+        uint32_t pos = it->second;
+        if (graph.nodeIndex[pos].removed || graph.nodeIndex[pos].edges != neighbors.size() + 1) {
+            continue;
+        }
+        twinNeighbors.clear();
+        graph.gatherNeighbors(graph.getNode(pos), twinNeighbors);
+        vector<uint32_t> uncommon;
+        set_difference(twinNeighbors.begin(), twinNeighbors.end(), neighbors.begin(), neighbors.end(), back_inserter(uncommon));
+        if (uncommon.size() == 1) {
+            uncommonNeighbor = uncommon[0];
+            return graph.getNode(pos);
+        }
+    }
+    return NONE;
+}
+
+/* Whether a node is unconfined depends on its neighbors and their neighbors, so only dirty nodes are checked */
 void Reductions::removeUnconfinedNodes2() {
-    Graph::GraphTraversal graphTraversal(graph);
-    while (graphTraversal.curNode != NONE) {
+    vector<uint32_t> nodes;
+    getDirtyNodes(unconfinedMark, nodes);
+    for (auto node: nodes) {
+        if (!isInGraph(node)) {
+            continue;
+        }
         bool isUnconfined = false;
         unordered_set<uint32_t> extendedGrandchildren;
+        Graph::GraphTraversal graphTraversal(graph, node);
         graph.getExtendedGrandchildren(graphTraversal, extendedGrandchildren, &isUnconfined);
         if (isUnconfined || !graph.isIndependentSet(extendedGrandchildren)) {
-            graph.remove(graphTraversal.curNode, reduceInfo);
+            graph.remove(node, reduceInfo);
         }
-        graph.getNextNode(graphTraversal);
     }
 }
 
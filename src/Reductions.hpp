@@ -6,7 +6,7 @@
 
 class Reductions {
 public:
-    Reductions(Graph &graph, Mis &mis) : graph(graph), mis(mis) {}
+    Reductions(Graph &graph, Mis &mis) : graph(graph), mis(mis), dominatedMark(NONE), unconfinedMark(NONE), shortFunnelMark(NONE), deskMark(NONE), shortFunnelMinDegree(NONE), signatureMark(NONE) {}
     ~Reductions();
     void run(const uint32_t &theta);
     ReduceInfo &getReduceInfo() {
@@ -17,11 +17,32 @@ public:
     }
 
 private:
+    bool isInGraph(const uint32_t &node) const {
+        uint32_t pos = graph.getPos(node);
+        return !graph.nodeIndex[pos].removed && graph.nodeIndex[pos].edges;
+    }
+
+    /* Order independent hash of a set of neighbors: the sum of a hash of each neighbor, plus SIGNATURE_DEGREE for each one */
+    static const uint64_t SIGNATURE_DEGREE = 1ULL << 61;
+    static uint64_t getNodeHash(const uint32_t &node) {
+        uint64_t hash = node + 0x9e3779b97f4a7c15ULL;
+        hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+        return hash ^ (hash >> 31);
+    }
+    static uint64_t getSignature(const std::vector<uint32_t> &neighbors) {
+        uint64_t signature = 0;
+        for (auto neighbor: neighbors) {
+            signature += getNodeHash(neighbor) + SIGNATURE_DEGREE;
+        }
+        return signature;
+    }
+
     /* Check whether subset is a subset of node's neighbors */
     static bool isSubsetOfNeighbors(const std::vector<Graph::GraphTraversal> &subset, const uint32_t &node, const Graph &graph) {
         uint32_t pos = graph.getPos(node);
         uint32_t count = subset.size();
-        uint32_t nextNodeOffset = (pos == graph.nodeIndex.size()-1 ? graph.edgeBuffer->size() : graph.nodeIndex[pos+1].offset);
+        uint32_t nextNodeOffset = graph.getSlotEnd(pos);
         for (uint32_t offset = graph.nodeIndex[pos].offset ; count && offset < nextNodeOffset ; offset++) {
             if (find((*graph.edgeBuffer)[offset], subset)) {
                 count--;
@@ -53,11 +74,16 @@ private:
     void reduce4(const uint32_t &theta);
     void reduce3(const uint32_t &theta);
     bool removeDesks();
+    bool removeDesk(const uint32_t &node);
     bool removeDominatedNodes(const uint32_t &theta);
     bool removeDominatedNodes2(const uint32_t &theta);
+    void removeDominatedNode(const uint32_t &pos1, const uint32_t &pos2, const uint32_t &theta);
+    bool isDominatedBy(const uint32_t &dominatedPos, const uint32_t &pos) const;
     bool removeShortFunnels(const uint32_t &theta);
+    bool removeShortFunnel(const uint32_t &nodeV, const uint32_t &theta, const uint32_t &minDegree);
     void removeEasyInstances(const uint32_t &theta);
     void findMis(const std::vector<uint32_t> &cc);
+    static void findMaxIndependentSet(const uint32_t *adjacency, const uint32_t &candidates, const uint32_t &set, uint32_t &maxSet);
     bool removeUnconfinedNodes();
     void removeUnconfinedNodes2();
     bool foldCompleteKIndependentSets(const uint32_t &theta, std::unordered_set<uint32_t> **oldCandidateNodes, std::unordered_set<uint32_t> **newCandidateNodes, const bool &theta4 = false);
@@ -65,6 +91,11 @@ private:
     void removeLineGraphs(const uint32_t &theta);
     bool findClique(std::vector<Graph::GraphTraversal> &clique, std::vector<Graph::GraphTraversal> *previousClique, const uint32_t &cliqueSize);
     void findMisInComponent(const std::vector<uint32_t> &cc);
+    void getDirtyNodes(uint32_t &mark, std::vector<uint32_t> &nodes);
+    void updateSignatures();
+    void indexSignature(const uint32_t &pos);
+    uint32_t getTwin(const uint32_t &node, const std::vector<uint32_t> &neighbors, const uint32_t &excluded);
+    uint32_t getNearTwin(const std::vector<uint32_t> &neighbors, uint32_t &uncommonNeighbor);
     void buildCC();
     void printCC() const;
     void printCCSizes() const;
@@ -74,6 +105,23 @@ private:
     Mis &mis;
     ReduceInfo reduceInfo;
     std::unordered_map<uint32_t, std::vector<uint32_t>* > ccToNodes;
+
+    /* Positions of the nodes modified during run(). Each rule keeps the end of this log at its previous pass,
+     * or NONE before its first pass in run(), to check only the nodes close to the modifications since */
+    std::vector<uint32_t> touchedNodes;
+    uint32_t dominatedMark;
+    uint32_t unconfinedMark;
+    uint32_t shortFunnelMark;
+    uint32_t deskMark;
+    uint32_t shortFunnelMinDegree; // Minimum degree at the previous pass of removeShortFunnels
+
+    /* Nodes of degree 3 and 4 by the signature of their neighbors, and nodes of degree 4 by the signature of every 3 of
+     * their neighbors, for finding the twins of foldCompleteKIndependentSets2 without scanning the graph.
+     * signatureMark is the end of touchedNodes at the previous update, or NONE until the index is built in run() */
+    std::unordered_multimap<uint64_t, uint32_t> twins;
+    std::unordered_multimap<uint64_t, uint32_t> nearTwins;
+    std::vector<uint64_t> signatureOfPos; // Signature of each indexed position, 0 for the ones not indexed
+    uint32_t signatureMark;
 };
 
 #endif
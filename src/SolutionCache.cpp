@@ -0,0 +1,52 @@
+#include <iostream>
+#include "SolutionCache.hpp"
+
+using namespace std;
+
+/* Check whether the cache settles if the graph of key has an independent set larger than target.
+ * If it does, beatsTarget is set, and the mis is appended to independentSet if it beats target */
+bool SolutionCache::find(const vector<uint64_t> &key, const uint32_t &target, vector<uint32_t> &independentSet, bool &beatsTarget) {
+    lookups++;
+    auto entry = entries.find(key);
+    if (entry == entries.end()) {
+        return false;
+    }
+    if (entry->second.exact) {
+        beatsTarget = entry->second.size > target;
+        if (beatsTarget) {
+            independentSet.insert(independentSet.end(), entry->second.independentSet.begin(), entry->second.independentSet.end());
+        }
+    } else if (entry->second.size <= target) {
+        beatsTarget = false;
+    } else {
+        return false;
+    }
+    hits++;
+    return true;
+}
+
+/* Keep the mis of the graph of key if it beat target, or else that its mis is at most target.
+ * Only called when find() did not settle it, so an existing entry is a looser bound */
+void SolutionCache::insert(const vector<uint64_t> &key, const uint32_t &target, const vector<uint32_t> &independentSet, const bool &beatsTarget) {
+    if (entries.size() >= MAX_ENTRIES) {
+        entries.clear();
+    }
+    Entry &entry = entries[key];
+    entry.exact = beatsTarget;
+    if (beatsTarget) {
+        entry.size = independentSet.size();
+        entry.independentSet = independentSet;
+    } else {
+        entry.size = target;
+    }
+}
+
+/* Add the stats of another cache, such as one of a parallel worker */
+void SolutionCache::mergeStats(const SolutionCache &solutionCache) {
+    lookups += solutionCache.lookups;
+    hits += solutionCache.hits;
+}
+
+void SolutionCache::printStats() const {
+    cout << "\nSolution cache: " << lookups << " lookups, " << hits << " hits\n";
+}
@@ -0,0 +1,46 @@
+#ifndef SOLUTION_CACHE_H
+#define SOLUTION_CACHE_H
+
+#include <unordered_map>
+#include "Util.hpp"
+
+/* Results of the small graph solver, keyed by the adjacency matrix of BitsetSolver. Isomorphic graphs show up
+ * in many search nodes, such as components of the same shape, and mostly get the same matrix. A cached mis is
+ * kept as indexes of the matrix, which is all of the key, so it is valid for any graph with the same key */
+class SolutionCache {
+public:
+    /* The cache is emptied once it reaches this many graphs, to bound its memory */
+    static const uint32_t MAX_ENTRIES = 1 << 14;
+
+    SolutionCache() : lookups(0), hits(0) {}
+    bool find(const std::vector<uint64_t> &key, const uint32_t &target, std::vector<uint32_t> &independentSet, bool &beatsTarget);
+    void insert(const std::vector<uint64_t> &key, const uint32_t &target, const std::vector<uint32_t> &independentSet, const bool &beatsTarget);
+    void mergeStats(const SolutionCache &solutionCache);
+    void printStats() const;
+
+private:
+    /* The mis of a graph, or only an upper bound of its size if no independent set beat a target */
+    struct Entry {
+    public:
+        bool exact;
+        uint32_t size;
+        std::vector<uint32_t> independentSet;
+    };
+
+    struct KeyHash {
+    public:
+        size_t operator()(const std::vector<uint64_t> &key) const {
+            uint64_t hash = key.size();
+            for (auto word: key) {
+                hash ^= word + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+            }
+            return hash;
+        }
+    };
+
+    std::unordered_map<std::vector<uint64_t>, Entry, KeyHash> entries;
+    uint64_t lookups;
+    uint64_t hits;
+};
+
+#endif
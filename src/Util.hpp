@@ -9,6 +9,20 @@
 bool isSubsetOf(const std::vector<uint32_t> &container1, std::vector<uint32_t>::iterator &begin, std::vector<uint32_t>::iterator &end);
 bool setsHaveKUncommonElements(const std::vector<uint32_t> &container1, const std::vector<uint32_t> &container2, const uint32_t &k, uint32_t &uncommonElement);
 
+/* Run options given from the command line */
+struct Options {
+public:
+    Options() : checkIndependentSet(false), trail(false), blocks(false), stats(false), threads(0), loadMemory(1024), compact(false), reorder(false) {}
+    bool checkIndependentSet;
+    bool trail; // Search on a single graph with an undo trail, instead of a graph copy per search node
+    bool blocks; // Fold the small blocks of the block-cut tree at the root, before the search
+    uint32_t threads; // Workers of the parallel engine, 0 for the sequential ones
+    bool stats; // Print statistics of the pruning bounds
+    uint32_t loadMemory; // Megabytes of parsed edges held in memory while loading, beyond which they are sorted in runs on disk
+    bool compact; // Renumber the ids of the input densely, and map them back only when writing the mis
+    bool reorder; // Renumber the input and lay out rebuilt graphs in breadth first order, for locality of neighbors
+};
+
 struct ReduceInfo {
 public:
     ReduceInfo() : nodesRemoved(0) {}